@@ -2,9 +2,51 @@ import argparse
 import os
 import subprocess
 
+# use the extension module when it is importable (i.e., built with
+# -DHYPERXSEARCH_PYTHON=ON and on PYTHONPATH) to search in-process
+try:
+  import hyperxsearch
+except ImportError:
+  hyperxsearch = None
+
+
+def formatRow(index, hx):
+  # formats a Hyperx like a row of the hyperxsearch output grid
+  return [str(index),
+          str(hx.dimensions),
+          '[' + ','.join([str(w) for w in hx.widths]) + ']',
+          '[' + ','.join([str(k) for k in hx.weights]) + ']',
+          str(hx.concentration),
+          str(hx.terminals),
+          str(hx.routers),
+          str(hx.router_radix),
+          str(hx.channels),
+          '[' + ','.join(['{:.2f}'.format(b) for b in hx.bisections]) + ']',
+          '{:f}'.format(hx.cost)]
+
 
 def getInfo(exe, maxradix, minterminals, minbandwidth, mindimensions,
             maxdimensions, minconcentration, maxconcentration):
+  if hyperxsearch is not None:
+    kwargs = {'max_radix': maxradix,
+              'min_terminals': minterminals,
+              'min_bandwidth': minbandwidth,
+              'max_dimensions': maxdimensions,
+              'max_results': 1}
+    if mindimensions:
+      kwargs['min_dimensions'] = mindimensions
+    if minconcentration:
+      kwargs['min_concentration'] = minconcentration
+    if maxconcentration:
+      kwargs['max_concentration'] = maxconcentration
+    engine = hyperxsearch.Engine(**kwargs)
+    engine.run()
+    results = engine.results()
+    if len(results) == 0:
+      return None
+    else:
+      return formatRow(1, results[0])
+
   cmd = ('{0} --maxradix {1} --minterminals {2} --minbandwidth {3} '
          '--maxdimensions {4} --maxresults 1').format(
            exe, maxradix, minterminals, minbandwidth, maxdimensions)
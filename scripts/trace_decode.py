@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+
+import argparse
+import collections
+import struct
+import sys
+
+MAGIC = b'HXTRACE1'
+DIMENSIONS = 14
+EVENT = struct.Struct('<BBBBI{0}H{0}H'.format(DIMENSIONS))
+BLOCK = struct.Struct('<II')
+
+STAGES = {1: 'stage1', 2: 'stage2', 3: 'stage3', 4: 'stage4', 5: 'stage5',
+          6: 'evaluate'}
+REASONS = {0: 'enter', 1: 'accept', 2: 'concentration', 3: 'terminals_low',
+           4: 'terminals_high', 5: 'radix_low', 6: 'radix_high',
+           7: 'bandwidth_low', 8: 'bandwidth_high', 9: 'infeasible',
+           10: 'pruned', 11: 'unclassified'}
+
+def events(filename):
+  # yields (thread, stage, reason, level, widths, weights, concentration)
+  with open(filename, 'rb') as fd:
+    header = fd.read(16)
+    if len(header) != 16 or header[:8] != MAGIC:
+      raise ValueError('{0} is not a hyperxsearch trace'.format(filename))
+    version, size = struct.unpack('<II', header[8:])
+    if version != 1 or size != EVENT.size:
+      raise ValueError('unsupported trace version {0} with {1} byte events'
+                       .format(version, size))
+    while True:
+      block = fd.read(BLOCK.size)
+      if len(block) < BLOCK.size:
+        break
+      thread, count = BLOCK.unpack(block)
+      data = fd.read(count * EVENT.size)
+      for idx in range(len(data) // EVENT.size):
+        fields = EVENT.unpack_from(data, idx * EVENT.size)
+        stage, reason, level, dims, conc = fields[:5]
+        dims = min(dims, DIMENSIONS)
+        widths = fields[5:5 + dims]
+        weights = fields[5 + DIMENSIONS:5 + DIMENSIONS + dims]
+        yield thread, stage, reason, level, widths, weights, conc
+
+def vec(values):
+  return '[' + ','.join(str(v) for v in values) + ']'
+
+def main(args):
+  stage_filter = set(args.stage) if args.stage else None
+  reason_filter = set(args.reason) if args.reason else None
+  totals = collections.Counter()
+  regions = collections.Counter()
+  printed = 0
+  for thread, stage, reason, level, widths, weights, conc in \
+      events(args.tracefile):
+    stage_name = STAGES.get(stage, str(stage))
+    reason_name = REASONS.get(reason, str(reason))
+    if stage_filter and stage_name not in stage_filter:
+      continue
+    if reason_filter and reason_name not in reason_filter:
+      continue
+    totals[(stage_name, reason_name)] += 1
+    regions[vec(widths)] += 1
+    if not args.summary and (args.limit == 0 or printed < args.limit):
+      # weights are only meaningful once stage3 assigns them
+      line = '{0} {1} {2} S={3} T={4}'.format(
+        thread, stage_name, reason_name, vec(widths), conc)
+      if stage >= 3:
+        line += ' K={0}'.format(vec(weights))
+      print(line)
+      printed += 1
+
+  if args.summary:
+    print('events by stage and reason:')
+    for (stage_name, reason_name), count in sorted(totals.items()):
+      print('  {0:<10} {1:<16} {2}'.format(stage_name, reason_name, count))
+    print('width configurations with the most events:')
+    for widths, count in regions.most_common(args.regions):
+      print('  {0:<24} {1}'.format(widths, count))
+
+if __name__ == '__main__':
+  ap = argparse.ArgumentParser(
+    description='decode a binary trace written by hyperxsearch --tracefile')
+  ap.add_argument('tracefile', help='the trace file')
+  ap.add_argument('-s', '--summary', action='store_true',
+                  help='print event counts instead of events')
+  ap.add_argument('-r', '--regions', type=int, default=10,
+                  help='number of width configurations in the summary')
+  ap.add_argument('--stage', action='append', choices=STAGES.values(),
+                  help='only decode events of this stage')
+  ap.add_argument('--reason', action='append', choices=REASONS.values(),
+                  help='only decode events of this reason')
+  ap.add_argument('-l', '--limit', type=int, default=0,
+                  help='maximum number of events printed (0 is unlimited)')
+  try:
+    main(ap.parse_args())
+  except BrokenPipeError:
+    sys.exit(0)
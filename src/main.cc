@@ -28,21 +28,113 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
+#include <algorithm>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "grid/Grid.h"
 #include "prim/prim.h"
+#include "search/Annealer.h"
 #include "search/Calculator.h"
 #include "search/CalculatorFactory.h"
+#include "search/CostExpression.h"
 #include "search/Engine.h"
+#include "search/Netlist.h"
+#include "search/ResultSpill.h"
+#include "search/RouterSkus.h"
+#include "search/Searcher.h"
+#include "search/SearcherFactory.h"
+#include "search/Trace.h"
 #include "strop/strop.h"
 #include "tclap/CmdLine.h"
 
+static std::vector<u64> parseList(const std::string& _list) {
+  std::vector<u64> values;
+  for (const std::string& value : strop::split(_list, ',')) {
+    values.push_back(std::stoull(value));
+  }
+  return values;
+}
+
+// the columns of a configuration and its calculator extension values
+static std::vector<std::string> resultHeader(const Calculator* _calc) {
+  std::vector<std::string> header = {
+      "#",         "Dimensions", "Widths", "Weights",  "Concentration",
+      "Terminals", "Routers",    "Radix",  "Channels", "Bisections",
+      "Cost"};
+  const std::vector<std::string>& ext_fields = _calc->extFields();
+  header.insert(header.end(), ext_fields.begin(), ext_fields.end());
+  return header;
+}
+
+static std::vector<std::string> resultRow(u64 _row, const Hyperx& _res,
+                                          const Calculator* _calc) {
+  // format the regular values
+  std::vector<std::string> row = {
+      std::to_string(_row),
+      std::to_string(_res.dimensions),
+      strop::vecString<u64>(_res.widths),
+      strop::vecString<u64>(_res.weights),
+      std::to_string(_res.concentration),
+      std::to_string(_res.terminals),
+      std::to_string(_res.routers),
+      std::to_string(_res.router_radix),
+      std::to_string(_res.channels),
+      strop::vecString<f64>(_res.bisections, ',', 2),
+      std::to_string(_res.cost)};
+
+  // get extension values from the calculator
+  const std::vector<std::string>& ext_fields = _calc->extFields();
+  const std::unordered_map<std::string, std::string>& ext_values =
+      _calc->extValues(_res);
+  for (const std::string& field : ext_fields) {
+    row.push_back(ext_values.at(field));
+  }
+  return row;
+}
+
+// prints the columns of a row separated by spaces
+static void printRow(const std::vector<std::string>& _columns) {
+  for (u64 col = 0; col < _columns.size(); col++) {
+    printf(col == 0 ? "%s" : " %s", _columns.at(col).c_str());
+  }
+  printf("\n");
+}
+
+// formats configurations and their calculator extension values as a grid,
+//  '_labels' are an optional second column named '_label'
+static std::string formatResults(
+    const std::deque<Hyperx>& _results, const Calculator* _calc,
+    const std::string& _label = "",
+    const std::vector<std::string>& _labels = {}) {
+  std::vector<std::string> header = resultHeader(_calc);
+  if (!_label.empty()) {
+    header.insert(header.begin() + 1, _label);
+  }
+  grid::Grid grid(1 + _results.size(), header.size());
+  for (u64 col = 0; col < header.size(); col++) {
+    grid.set(0, col, header.at(col));
+  }
+  for (u64 idx = 0; idx < _results.size(); idx++) {
+    u64 row = idx + 1;
+    std::vector<std::string> values = resultRow(row, _results.at(idx), _calc);
+    if (!_label.empty()) {
+      values.insert(values.begin() + 1, _labels.at(idx));
+    }
+    for (u64 col = 0; col < values.size(); col++) {
+      grid.set(row, col, values.at(col));
+    }
+  }
+  return grid.toString();
+}
+
 s32 main(s32 _argc, char** _argv) {
   u64 min_dimensions;
   u64 max_dimensions;
@@ -59,8 +151,32 @@ s32 main(s32 _argc, char** _argv) {
   bool fixed_width;
   bool fixed_weight;
   u64 max_results;
+  f64 time_limit;
+  u64 node_limit;
+  u64 spill_memory;
+  std::string spill_dir;
+  bool count;
+  bool heuristic;
+  bool heuristic_quality;
+  bool bandwidth_curve;
+  u64 chains;
+  u64 steps;
+  u64 seed;
+  std::string trace_file;
+  u64 trace_level;
+  u64 trace_sample;
   bool print_settings;
   std::string cost_calc;
+  std::string cost_expr;
+  std::string cost_consts;
+  std::string sku_file;
+  std::string families_list;
+  std::string netlist_file;
+  std::string netlist_format;
+  std::string widths;
+  std::string weights;
+  u64 concentration;
+  std::vector<std::string> families;
 
   std::string version = "1.1";
   std::string description =
@@ -114,9 +230,98 @@ s32 main(s32 _argc, char** _argv) {
         false);
     TCLAP::ValueArg<u64> max_results_arg(
         "", "maxresults", "maximum number of results", false, 10, "u64", cmd);
+    TCLAP::ValueArg<f64> time_limit_arg(
+        "", "timelimit",
+        "search the most promising configurations first and stop after this "
+        "many seconds (0 is unlimited)",
+        false, 0.0, "f64", cmd);
+    TCLAP::ValueArg<u64> node_limit_arg(
+        "", "nodelimit",
+        "search the most promising configurations first and stop after "
+        "visiting this many weight configurations (0 is unlimited)",
+        false, 0, "u64", cmd);
+    TCLAP::ValueArg<u64> spill_memory_arg(
+        "", "spillmemory",
+        "keep the results in this many MiB of memory and spill the rest to "
+        "disk, for very large maxresults (0 keeps all results in memory)",
+        false, 0, "u64", cmd);
+    TCLAP::ValueArg<std::string> spill_dir_arg(
+        "", "spilldir", "directory of the spilled results", false, "/tmp",
+        "string", cmd);
+    TCLAP::SwitchArg count_arg(
+        "", "count",
+        "count the configurations in the search space instead of searching",
+        cmd, false);
+    TCLAP::SwitchArg heuristic_arg(
+        "", "heuristic",
+        "search with simulated annealing instead of exhaustively", cmd, false);
+    TCLAP::SwitchArg heuristic_quality_arg(
+        "", "heuristicquality",
+        "run both the heuristic and the exhaustive search and compare them",
+        cmd, false);
+    TCLAP::SwitchArg bandwidth_curve_arg(
+        "", "bandwidthcurve",
+        "also print the cheapest configuration for every minimum bandwidth",
+        cmd, false);
+    TCLAP::ValueArg<u64> chains_arg("", "chains",
+                                    "number of independent annealing chains",
+                                    false, 8, "u64", cmd);
+    TCLAP::ValueArg<u64> steps_arg("", "steps",
+                                   "number of annealing steps per chain",
+                                   false, 100000, "u64", cmd);
+    TCLAP::ValueArg<u64> seed_arg("", "seed", "random seed of the heuristic",
+                                  false, 12345678, "u64", cmd);
+    TCLAP::ValueArg<std::string> trace_file_arg(
+        "", "tracefile", "binary trace output file (see trace_decode.py)",
+        false, "", "string", cmd);
+    TCLAP::ValueArg<u64> trace_level_arg(
+        "", "tracelevel",
+        "trace detail (2=costed, 3=feasible, 4=stage3, 5=stage2, 6=stage1 and "
+        "radix skips, 7=all skips)",
+        false, 4, "u64", cmd);
+    TCLAP::ValueArg<u64> trace_sample_arg(
+        "", "tracesample", "only trace 1 of every this many events", false, 1,
+        "u64", cmd);
+    TCLAP::ValueArg<std::string> families_arg(
+        "", "families",
+        "comma separated topology families to search (hyperx, dragonfly, "
+        "fattree, torus)",
+        false, "hyperx", "string", cmd);
+    TCLAP::ValueArg<std::string> netlist_arg(
+        "", "netlist",
+        "write the channel list of the configuration given by --widths, "
+        "--weights, and --concentration to this file ('-' is stdout) instead "
+        "of searching",
+        false, "", "string", cmd);
+    TCLAP::ValueArg<std::string> netlist_format_arg(
+        "", "netformat", "netlist format (text or binary)", false, "text",
+        "string", cmd);
+    TCLAP::ValueArg<std::string> widths_arg(
+        "", "widths", "comma separated dimension widths of the netlist", false,
+        "", "string", cmd);
+    TCLAP::ValueArg<std::string> weights_arg(
+        "", "weights", "comma separated dimension weights of the netlist",
+        false, "", "string", cmd);
+    TCLAP::ValueArg<u64> concentration_arg(
+        "", "concentration", "router concentration of the netlist", false, 1,
+        "u64", cmd);
     TCLAP::ValueArg<std::string> cost_calc_arg(
         "", "costcalc", "cost calculator to use", false, "router_channel_count",
         "string", cmd);
+    TCLAP::ValueArg<std::string> cost_expr_arg(
+        "", "costexpr",
+        "cost expression over the HyperX fields, replacing the cost "
+        "calculator",
+        false, "", "string", cmd);
+    TCLAP::ValueArg<std::string> cost_consts_arg(
+        "", "costconst",
+        "comma separated NAME=value constants of the cost expression", false,
+        "", "string", cmd);
+    TCLAP::ValueArg<std::string> sku_file_arg(
+        "", "skus",
+        "router SKU file, the cheapest fitting SKU adds to the cost and the "
+        "largest SKU radix limits the maximum radix",
+        false, "", "string", cmd);
     TCLAP::SwitchArg print_settings_arg("p", "printsettings",
                                         "print the input settings", cmd, false);
 
@@ -142,8 +347,32 @@ s32 main(s32 _argc, char** _argv) {
     fixed_width = fixed_width_arg.getValue();
     fixed_weight = fixed_weight_arg.getValue();
     max_results = max_results_arg.getValue();
+    time_limit = time_limit_arg.getValue();
+    node_limit = node_limit_arg.getValue();
+    spill_memory = spill_memory_arg.getValue();
+    spill_dir = spill_dir_arg.getValue();
+    count = count_arg.getValue();
+    heuristic = heuristic_arg.getValue();
+    heuristic_quality = heuristic_quality_arg.getValue();
+    bandwidth_curve = bandwidth_curve_arg.getValue();
+    chains = chains_arg.getValue();
+    steps = steps_arg.getValue();
+    seed = seed_arg.getValue();
+    trace_file = trace_file_arg.getValue();
+    trace_level = trace_level_arg.getValue();
+    trace_sample = trace_sample_arg.getValue();
     print_settings = print_settings_arg.getValue();
     cost_calc = cost_calc_arg.getValue();
+    cost_expr = cost_expr_arg.getValue();
+    cost_consts = cost_consts_arg.getValue();
+    sku_file = sku_file_arg.getValue();
+    families_list = families_arg.getValue();
+    families = strop::split(families_list, ',');
+    netlist_file = netlist_arg.getValue();
+    netlist_format = netlist_format_arg.getValue();
+    widths = widths_arg.getValue();
+    weights = weights_arg.getValue();
+    concentration = concentration_arg.getValue();
   } catch (TCLAP::ArgException& e) {
     throw std::runtime_error(e.error().c_str());
   }
@@ -167,81 +396,404 @@ s32 main(s32 _argc, char** _argv) {
         "  fixed_width = %s\n"
         "  fixed_weight = %s\n"
         "  max_results = %lu\n"
+        "  time_limit = %f\n"
+        "  node_limit = %lu\n"
+        "  spill_memory = %lu\n"
+        "  spill_dir = %s\n"
+        "  count = %s\n"
+        "  heuristic = %s\n"
+        "  heuristic_quality = %s\n"
+        "  bandwidth_curve = %s\n"
+        "  chains = %lu\n"
+        "  steps = %lu\n"
+        "  seed = %lu\n"
+        "  trace_file = %s\n"
+        "  trace_level = %lu\n"
+        "  trace_sample = %lu\n"
+        "  families = %s\n"
+        "  netlist = %s\n"
+        "  netformat = %s\n"
+        "  widths = %s\n"
+        "  weights = %s\n"
+        "  concentration = %lu\n"
         "  cost_calc = %s\n"
+        "  cost_expr = %s\n"
+        "  cost_consts = %s\n"
+        "  skus = %s\n"
         "\n",
         min_dimensions, max_dimensions, min_radix, max_radix, min_concentration,
         max_concentration, min_terminals, max_terminals, min_bandwidth,
         max_bandwidth, max_width, max_weight, (fixed_width ? "yes" : "no"),
-        (fixed_weight ? "yes" : "no"), max_results, cost_calc.c_str());
+        (fixed_weight ? "yes" : "no"), max_results, time_limit, node_limit,
+        spill_memory, spill_dir.c_str(), (count ? "yes" : "no"),
+        (heuristic ? "yes" : "no"), (heuristic_quality ? "yes" : "no"),
+        (bandwidth_curve ? "yes" : "no"), chains, steps, seed,
+        trace_file.c_str(), trace_level, trace_sample,
+        families_list.c_str(), netlist_file.c_str(), netlist_format.c_str(),
+        widths.c_str(), weights.c_str(), concentration, cost_calc.c_str(),
+        cost_expr.c_str(), cost_consts.c_str(), sku_file.c_str());
+  }
+
+  // write a netlist instead of searching
+  if (!netlist_file.empty()) {
+    Hyperx hyperx;
+    hyperx.widths = parseList(widths);
+    hyperx.weights = parseList(weights);
+    hyperx.dimensions = hyperx.widths.size();
+    hyperx.concentration = concentration;
+    Netlist::Format format;
+    if (netlist_format == "text") {
+      format = Netlist::Format::kText;
+    } else if (netlist_format == "binary") {
+      format = Netlist::Format::kBinary;
+    } else {
+      throw std::runtime_error("unknown netlist format: " + netlist_format);
+    }
+    Netlist netlist(hyperx, format);
+
+    FILE* file = (netlist_file == "-") ? stdout
+                                       : fopen(netlist_file.c_str(), "wb");
+    if (file == nullptr) {
+      throw std::runtime_error("unable to open " + netlist_file);
+    }
+    u64 channels = netlist.write(file);
+    if (file != stdout) {
+      fclose(file);
+    }
+
+    // the netlist must have exactly the channels the search counts
+    hyperx.routers = 1;
+    for (u64 width : hyperx.widths) {
+      hyperx.routers *= width;
+    }
+    hyperx.terminals = hyperx.routers * hyperx.concentration;
+    u64 expected = Engine::channelCount(hyperx);
+    fprintf(stderr, "netlist: %lu channels (%lu terminal, %lu router)\n",
+            channels, hyperx.terminals, channels - hyperx.terminals);
+    if (channels != expected) {
+      throw std::runtime_error("netlist has " + std::to_string(channels) +
+                               " channels, expected " +
+                               std::to_string(expected));
+    }
+    return 0;
   }
 
-  // create the cost calculator
-  Calculator* calc = CalculatorFactory::createCalculator(cost_calc);
+  // create the cost calculator, a cost expression replaces it
+  Calculator* calc;
+  if (cost_expr.empty()) {
+    calc = CalculatorFactory::createCalculator(cost_calc);
+  } else {
+    std::unordered_map<std::string, f64> constants;
+    for (const std::string& constant : strop::split(cost_consts, ',')) {
+      size_t equals = constant.find('=');
+      if (equals == std::string::npos) {
+        throw std::runtime_error("invalid cost constant: " + constant);
+      }
+      constants[constant.substr(0, equals)] =
+          std::stod(constant.substr(equals + 1));
+    }
+    calc = new CostExpression(cost_expr, constants);
+  }
+
+  // price the routers by SKU, searching up to the largest SKU radix within
+  //  the maximum radix and the bandwidths any SKU speed can bring within the
+  //  limits
+  RouterSkus* skus = nullptr;
+  if (!sku_file.empty()) {
+    skus = new RouterSkus(sku_file, calc, min_bandwidth, max_bandwidth);
+    calc = skus;
+    max_radix = std::min(max_radix, skus->maxRadix());
+    skus->engineBandwidth(&min_bandwidth, &max_bandwidth);
+  }
 
   // create and run the engine
-  Engine engine(min_dimensions, max_dimensions, min_radix, max_radix,
-                min_concentration, max_concentration, min_terminals,
-                max_terminals, min_bandwidth, max_bandwidth, max_width,
-                max_weight, fixed_width, fixed_weight, max_results, calc);
-  engine.run();
+  std::unique_ptr<Engine> engine(CalculatorFactory::createEngine(
+      min_dimensions, max_dimensions, min_radix, max_radix, min_concentration,
+      max_concentration, min_terminals, max_terminals, min_bandwidth,
+      max_bandwidth, max_width, max_weight, fixed_width, fixed_weight,
+      max_results, calc));
+
+  // trace the search when requested
+  std::unique_ptr<Tracer> tracer;
+  if (!trace_file.empty()) {
+    u8 level = static_cast<u8>(std::min<u64>(trace_level, U8_MAX));
+    tracer.reset(new Tracer(trace_file, level, trace_sample));
+    engine->setTracer(tracer.get());
+  }
+
+  // keep the results on disk beyond the memory limit
+  std::unique_ptr<ResultSpill> spill;
+  if (spill_memory > 0) {
+    if (heuristic || heuristic_quality || (families.size() != 1) ||
+        (families.at(0) != "hyperx")) {
+      throw std::runtime_error(
+          "spilling results only supports the exhaustive hyperx search");
+    }
+    spill.reset(new ResultSpill(max_results, max_dimensions,
+                                spill_memory << 20, spill_dir));
+    engine->setResultSpill(spill.get());
+  }
+
+  // search several topology families and merge their results
+  if ((families.size() != 1) || (families.at(0) != "hyperx")) {
+    if (count || heuristic || heuristic_quality || bandwidth_curve) {
+      throw std::runtime_error(
+          "counting, heuristic search, and the bandwidth curve only support "
+          "the hyperx family");
+    }
+    engine->setBudget(time_limit, node_limit);
+
+    // create and run the searchers
+    std::vector<std::unique_ptr<Searcher>> owned;
+    std::vector<Searcher*> searchers;
+    for (const std::string& family : families) {
+      if (family == "hyperx") {
+        searchers.push_back(engine.get());
+      } else {
+        owned.emplace_back(
+            SearcherFactory::createSearcher(family, engine.get()));
+        searchers.push_back(owned.back().get());
+      }
+    }
+    for (Searcher* searcher : searchers) {
+      searcher->run();
+    }
+
+    // merge the results into a single top-K, ties keep the family order
+    std::vector<std::pair<const Searcher*, u64>> merged;
+    for (const Searcher* searcher : searchers) {
+      for (u64 idx = 0; idx < searcher->numResults(); idx++) {
+        merged.push_back({searcher, idx});
+      }
+    }
+    std::stable_sort(merged.begin(), merged.end(),
+                     [](const std::pair<const Searcher*, u64>& _lhs,
+                        const std::pair<const Searcher*, u64>& _rhs) {
+                       return _lhs.first->result(_lhs.second).cost <
+                              _rhs.first->result(_rhs.second).cost;
+                     });
+    if (merged.size() > max_results) {
+      merged.resize(max_results);
+    }
+
+    // let the calculator analyze the HyperX results before formatting them
+    if (std::find(families.begin(), families.end(), "hyperx") !=
+        families.end()) {
+      calc->analyze(engine->results());
+    }
+
+    // create the output grid, HyperX results have all extension values
+    const std::vector<std::string>& ext_fields = calc->extFields();
+    grid::Grid grid(1 + merged.size(), 9 + ext_fields.size());
+    grid.set(0, 0, "#");
+    grid.set(0, 1, "Family");
+    grid.set(0, 2, "Parameters");
+    grid.set(0, 3, "Terminals");
+    grid.set(0, 4, "Routers");
+    grid.set(0, 5, "Radix");
+    grid.set(0, 6, "Channels");
+    grid.set(0, 7, "Bisections");
+    grid.set(0, 8, "Cost");
+    for (u64 col = 0; col < ext_fields.size(); col++) {
+      grid.set(0, 9 + col, ext_fields.at(col));
+    }
+    for (u64 idx = 0; idx < merged.size(); idx++) {
+      u64 row = idx + 1;
+      const Searcher* searcher = merged.at(idx).first;
+      const Network& res = searcher->result(merged.at(idx).second);
+      grid.set(row, 0, std::to_string(row));
+      grid.set(row, 1, searcher->family());
+      grid.set(row, 2, searcher->parameters(merged.at(idx).second));
+      grid.set(row, 3, std::to_string(res.terminals));
+      grid.set(row, 4, std::to_string(res.routers));
+      grid.set(row, 5, std::to_string(res.router_radix));
+      grid.set(row, 6, std::to_string(res.channels));
+      grid.set(row, 7, strop::vecString<f64>(res.bisections, ',', 2).c_str());
+      grid.set(row, 8, std::to_string(res.cost));
+      std::unordered_map<std::string, std::string> ext_values =
+          (searcher == engine.get())
+              ? calc->extValues(static_cast<const Hyperx&>(res))
+              : calc->networkExtValues(res);
+      for (u64 col = 0; col < ext_fields.size(); col++) {
+        auto value = ext_values.find(ext_fields.at(col));
+        grid.set(row, 9 + col,
+                 (value == ext_values.end()) ? "-" : value->second);
+      }
+    }
+    printf("%s", grid.toString().c_str());
+    delete calc;
+    return 0;
+  }
+
+  // in counting mode, only print the size of the search space
+  if (count) {
+    engine->count();
+    const std::vector<SpaceCount>& counts = engine->counts();
+    grid::Grid grid(2 + counts.size(), 5);
+    grid.set(0, 0, "Dimensions");
+    grid.set(0, 1, "WidthConfigs");
+    grid.set(0, 2, "Stage3Calls");
+    grid.set(0, 3, "Nodes");
+    grid.set(0, 4, "Feasible");
+    SpaceCount total = {0, 0, 0, 0, 0};
+    for (u64 idx = 0; idx < counts.size(); idx++) {
+      const SpaceCount& cnt = counts.at(idx);
+      grid.set(idx + 1, 0, std::to_string(cnt.dimensions));
+      grid.set(idx + 1, 1, std::to_string(cnt.regions));
+      grid.set(idx + 1, 2, std::to_string(cnt.stage3s));
+      grid.set(idx + 1, 3, std::to_string(cnt.nodes));
+      grid.set(idx + 1, 4, std::to_string(cnt.feasible));
+      total.regions += cnt.regions;
+      total.stage3s += cnt.stage3s;
+      total.nodes += cnt.nodes;
+      total.feasible += cnt.feasible;
+    }
+    grid.set(counts.size() + 1, 0, "Total");
+    grid.set(counts.size() + 1, 1, std::to_string(total.regions));
+    grid.set(counts.size() + 1, 2, std::to_string(total.stage3s));
+    grid.set(counts.size() + 1, 3, std::to_string(total.nodes));
+    grid.set(counts.size() + 1, 4, std::to_string(total.feasible));
+    printf("%s", grid.toString().c_str());
+    delete calc;
+    return 0;
+  }
+
+  // run the heuristic search
+  std::unique_ptr<Annealer> annealer;
+  f64 annealer_seconds = 0.0;
+  if (heuristic || heuristic_quality) {
+    annealer.reset(new Annealer(engine.get(), chains, steps, seed));
+    auto start = std::chrono::steady_clock::now();
+    annealer->run();
+    annealer_seconds = std::chrono::duration<f64>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  }
+
+  engine->setBandwidthCurve(bandwidth_curve);
+  engine->setBudget(time_limit, node_limit);
+  if (engine->budgeted() && !heuristic) {
+    // publish the best result as it improves
+    auto start = std::chrono::steady_clock::now();
+    engine->setImprovementHandler([&start](const Hyperx& _best) {
+      f64 seconds = std::chrono::duration<f64>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+      fprintf(stderr, "%.3fs: best S=%s K=%s T=%lu cost=%f\n", seconds,
+              strop::vecString<u64>(_best.widths).c_str(),
+              strop::vecString<u64>(_best.weights).c_str(),
+              _best.concentration, _best.cost);
+    });
+  }
+  f64 engine_seconds = 0.0;
+  if (!heuristic || heuristic_quality) {
+    auto start = std::chrono::steady_clock::now();
+    engine->run();
+    engine_seconds = std::chrono::duration<f64>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  }
 
   // gather the results
-  const std::deque<Hyperx>& results = engine.results();
-
-  // create the output grid
-  const std::vector<std::string>& ext_fields = calc->extFields();
-  grid::Grid grid(1 + results.size(), 11 + ext_fields.size());
-
-  // format the regular header
-  grid.set(0, 0, "#");
-  grid.set(0, 1, "Dimensions");
-  grid.set(0, 2, "Widths");
-  grid.set(0, 3, "Weights");
-  grid.set(0, 4, "Concentration");
-  grid.set(0, 5, "Terminals");
-  grid.set(0, 6, "Routers");
-  grid.set(0, 7, "Radix");
-  grid.set(0, 8, "Channels");
-  grid.set(0, 9, "Bisections");
-  grid.set(0, 10, "Cost");
-
-  // format the extension header
-  for (u64 ext = 0; ext < ext_fields.size(); ext++) {
-    grid.set(0, 11 + ext, ext_fields.at(ext));
-  }
-
-  // format the data section
-  for (u64 idx = 0; idx < results.size(); idx++) {
-    u64 row = idx + 1;
+  const std::deque<Hyperx>& results =
+      annealer ? annealer->results() : engine->results();
 
-    // get the results
-    const Hyperx& res = results.at(idx);
+  if (spill) {
+    // stream the spilled results as they merge, they only keep the fields
+    //  that evaluate() recomputes the others from
+    printRow(resultHeader(calc));
+    u64 row = 0;
+    spill->merge([&](const Hyperx& _res) {
+      Hyperx res = _res;
+      engine->evaluate(&res);
+      printRow(resultRow(++row, res, calc));
+    });
+  } else {
+    // let the calculator analyze the results before formatting them
+    calc->analyze(results);
+
+    // print the output grid
+    printf("%s", formatResults(results, calc).c_str());
+  }
 
-    // format the regular values in the row
-    grid.set(row, 0, std::to_string(row));
-    grid.set(row, 1, std::to_string(res.dimensions));
-    grid.set(row, 2, strop::vecString<u64>(res.widths).c_str());
-    grid.set(row, 3, strop::vecString<u64>(res.weights).c_str());
-    grid.set(row, 4, std::to_string(res.concentration));
-    grid.set(row, 5, std::to_string(res.terminals));
-    grid.set(row, 6, std::to_string(res.routers));
-    grid.set(row, 7, std::to_string(res.router_radix));
-    grid.set(row, 8, std::to_string(res.channels));
-    grid.set(row, 9, strop::vecString<f64>(res.bisections, ',', 2).c_str());
-    grid.set(row, 10, std::to_string(res.cost));
+  // print the cost/bandwidth trade-off curve, each step is the cheapest
+  //  configuration for the minimum bandwidths up to its smallest bisection
+  if (bandwidth_curve && (!heuristic || heuristic_quality)) {
+    std::deque<Hyperx> steps;
+    std::vector<std::string> thresholds;
+    for (const std::pair<const f64, Hyperx>& step :
+         engine->bandwidthCurve()) {
+      steps.push_back(step.second);
+      char threshold[32];
+      snprintf(threshold, sizeof(threshold), "%.2f", step.first);
+      thresholds.push_back(threshold);
+    }
+    calc->analyze(steps);
+    printf("\nbandwidth curve:\n%s",
+           formatResults(steps, calc, "MinBandwidth", thresholds).c_str());
+  }
 
-    // get extension values from the calculator
-    const std::unordered_map<std::string, std::string>& ext_values =
-        calc->extValues(res);
+  // print the best configuration of each SKU
+  if (skus && (!heuristic || heuristic_quality)) {
+    std::deque<Hyperx> best;
+    for (const Hyperx& res : engine->classBest()) {
+      if (res.dimensions > 0) {
+        best.push_back(res);
+      }
+    }
+    calc->analyze(best);
+    printf("\nbest per SKU:\n%s", formatResults(best, calc).c_str());
+  }
 
-    // format the extensions values in the row
-    for (u64 ext = 0; ext < ext_fields.size(); ext++) {
-      grid.set(row, 11 + ext, ext_values.at(ext_fields.at(ext)));
+  // compare the heuristic to the exhaustive search
+  if (heuristic_quality) {
+    const std::deque<Hyperx>& exact = engine->results();
+    u64 overlap = 0;
+    for (const Hyperx& res : results) {
+      for (const Hyperx& ex : exact) {
+        if ((res.widths == ex.widths) && (res.weights == ex.weights) &&
+            (res.concentration == ex.concentration)) {
+          overlap++;
+          break;
+        }
+      }
+    }
+    printf("\nheuristic: %lu evaluations in %.3f seconds\n",
+           annealer->evaluations(), annealer_seconds);
+    printf("exhaustive: %lu nodes in %.3f seconds%s\n",
+           engine->coverage().nodes, engine_seconds,
+           engine->coverage().complete ? "" : " (stopped by budget)");
+    if (results.empty() || exact.empty()) {
+      printf("best cost gap: n/a (heuristic %lu results, exhaustive %lu)\n",
+             results.size(), exact.size());
+    } else {
+      printf("best cost gap: %.3f%% (heuristic %f, exhaustive %f)\n",
+             100.0 * (results.front().cost - exact.front().cost) /
+                 exact.front().cost,
+             results.front().cost, exact.front().cost);
     }
+    printf("top-%lu overlap: %lu of %lu\n", max_results, overlap,
+           exact.size());
   }
 
-  // print the output grid
-  printf("%s", grid.toString().c_str());
+  // report how much of the space a budgeted search covered
+  if (engine->budgeted() && !heuristic) {
+    const Coverage& coverage = engine->coverage();
+    printf(
+        "\nsearch %s after %.3f seconds: %lu nodes, %lu of %lu width "
+        "configurations (%.2f%%)\n",
+        coverage.complete ? "completed" : "stopped by budget",
+        coverage.seconds, coverage.nodes, coverage.regions_searched,
+        coverage.regions,
+        (coverage.regions == 0)
+            ? 100.0
+            : (100.0 * coverage.regions_searched) / coverage.regions);
+  }
+
+  // report a failed trace write after the results
+  if (tracer) {
+    tracer->flush();
+  }
 
   // cleanup
   delete calc;
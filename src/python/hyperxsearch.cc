@@ -0,0 +1,587 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Calculator.h"
+#include "search/CalculatorFactory.h"
+#include "search/Engine.h"
+
+/*
+ * This module exposes the search engine to Python so that scripts can run
+ * searches in-process instead of formatting command lines and parsing the
+ * text output of the hyperxsearch executable. Engine.run() releases the GIL
+ * so that independent engines can run concurrently on several threads.
+ */
+
+namespace {
+
+// Hyperx records are returned as struct sequences (named tuples)
+PyStructSequence_Field kHyperxFields[] = {
+    {"dimensions", "number of dimensions (L)"},
+    {"widths", "width of each dimension (S)"},
+    {"weights", "weight of each dimension (K)"},
+    {"concentration", "terminals per router (T)"},
+    {"terminals", "number of terminals (N)"},
+    {"routers", "number of routers (P)"},
+    {"router_radix", "router radix (R)"},
+    {"channels", "number of channels"},
+    {"bisections", "relative bisection bandwidth of each dimension (B)"},
+    {"cost", "cost as computed by the cost calculator"},
+    {nullptr, nullptr}};
+
+PyStructSequence_Desc kHyperxDesc = {
+    "hyperxsearch.Hyperx", "A HyperX configuration produced by a search.",
+    kHyperxFields, 10};
+
+PyTypeObject* HyperxType = nullptr;
+
+template <typename T>
+PyObject* toTuple(const std::vector<T>& _values) {
+  PyObject* tuple = PyTuple_New(_values.size());
+  if (tuple == nullptr) {
+    return nullptr;
+  }
+  for (u64 idx = 0; idx < _values.size(); idx++) {
+    PyObject* value;
+    if constexpr (std::is_floating_point<T>::value) {
+      value = PyFloat_FromDouble(_values.at(idx));
+    } else {
+      value = PyLong_FromUnsignedLongLong(_values.at(idx));
+    }
+    if (value == nullptr) {
+      Py_DECREF(tuple);
+      return nullptr;
+    }
+    PyTuple_SET_ITEM(tuple, idx, value);
+  }
+  return tuple;
+}
+
+PyObject* toPython(const Hyperx& _hyperx) {
+  PyObject* obj = PyStructSequence_New(HyperxType);
+  if (obj == nullptr) {
+    return nullptr;
+  }
+  PyObject* values[] = {PyLong_FromUnsignedLongLong(_hyperx.dimensions),
+                        toTuple(_hyperx.widths),
+                        toTuple(_hyperx.weights),
+                        PyLong_FromUnsignedLongLong(_hyperx.concentration),
+                        PyLong_FromUnsignedLongLong(_hyperx.terminals),
+                        PyLong_FromUnsignedLongLong(_hyperx.routers),
+                        PyLong_FromUnsignedLongLong(_hyperx.router_radix),
+                        PyLong_FromUnsignedLongLong(_hyperx.channels),
+                        toTuple(_hyperx.bisections),
+                        PyFloat_FromDouble(_hyperx.cost)};
+  bool failed = false;
+  for (u64 idx = 0; idx < 10; idx++) {
+    if (values[idx] == nullptr) {
+      failed = true;
+    } else {
+      PyStructSequence_SET_ITEM(obj, idx, values[idx]);
+    }
+  }
+  if (failed) {
+    Py_DECREF(obj);
+    return nullptr;
+  }
+  return obj;
+}
+
+bool getU64(PyObject* _obj, const char* _name, u64* _value) {
+  PyObject* attr = PyObject_GetAttrString(_obj, _name);
+  if (attr == nullptr) {
+    return false;
+  }
+  *_value = PyLong_AsUnsignedLongLong(attr);
+  Py_DECREF(attr);
+  return !PyErr_Occurred();
+}
+
+template <typename T>
+bool getVector(PyObject* _obj, const char* _name, std::vector<T>* _values) {
+  PyObject* attr = PyObject_GetAttrString(_obj, _name);
+  if (attr == nullptr) {
+    return false;
+  }
+  PyObject* seq = PySequence_Fast(attr, "expected a sequence");
+  Py_DECREF(attr);
+  if (seq == nullptr) {
+    return false;
+  }
+  _values->clear();
+  for (Py_ssize_t idx = 0; idx < PySequence_Fast_GET_SIZE(seq); idx++) {
+    PyObject* item = PySequence_Fast_GET_ITEM(seq, idx);
+    if constexpr (std::is_floating_point<T>::value) {
+      _values->push_back(PyFloat_AsDouble(item));
+    } else {
+      _values->push_back(PyLong_AsUnsignedLongLong(item));
+    }
+  }
+  Py_DECREF(seq);
+  return !PyErr_Occurred();
+}
+
+bool fromPython(PyObject* _obj, Hyperx* _hyperx) {
+  PyObject* cost;
+  if (!getU64(_obj, "dimensions", &_hyperx->dimensions) ||
+      !getVector(_obj, "widths", &_hyperx->widths) ||
+      !getVector(_obj, "weights", &_hyperx->weights) ||
+      !getU64(_obj, "concentration", &_hyperx->concentration) ||
+      !getU64(_obj, "terminals", &_hyperx->terminals) ||
+      !getU64(_obj, "routers", &_hyperx->routers) ||
+      !getU64(_obj, "router_radix", &_hyperx->router_radix) ||
+      !getU64(_obj, "channels", &_hyperx->channels) ||
+      !getVector(_obj, "bisections", &_hyperx->bisections) ||
+      (cost = PyObject_GetAttrString(_obj, "cost")) == nullptr) {
+    return false;
+  }
+  _hyperx->cost = PyFloat_AsDouble(cost);
+  Py_DECREF(cost);
+  if (PyErr_Occurred()) {
+    return false;
+  }
+  if ((_hyperx->widths.size() != _hyperx->dimensions) ||
+      (_hyperx->weights.size() != _hyperx->dimensions)) {
+    PyErr_SetString(PyExc_ValueError,
+                    "widths and weights must have 'dimensions' entries");
+    return false;
+  }
+  return true;
+}
+
+/*
+ * hyperxsearch.Calculator
+ */
+struct CalculatorObject {
+  PyObject_HEAD
+  Calculator* calc;
+};
+
+PyObject* Calculator_new(PyTypeObject* _type, PyObject* _args,
+                         PyObject* _kwds) {
+  static const char* kwlist[] = {"name", nullptr};
+  const char* name = "router_channel_count";
+  if (!PyArg_ParseTupleAndKeywords(_args, _kwds, "|s",
+                                   const_cast<char**>(kwlist), &name)) {
+    return nullptr;
+  }
+  Calculator* calc;
+  try {
+    calc = CalculatorFactory::createCalculator(name);
+  } catch (std::exception& ex) {
+    PyErr_SetString(PyExc_ValueError, ex.what());
+    return nullptr;
+  }
+  CalculatorObject* self =
+      reinterpret_cast<CalculatorObject*>(_type->tp_alloc(_type, 0));
+  if (self == nullptr) {
+    delete calc;
+    return nullptr;
+  }
+  self->calc = calc;
+  return reinterpret_cast<PyObject*>(self);
+}
+
+void Calculator_dealloc(PyObject* _self) {
+  CalculatorObject* self = reinterpret_cast<CalculatorObject*>(_self);
+  delete self->calc;
+  Py_TYPE(_self)->tp_free(_self);
+}
+
+PyObject* Calculator_cost(PyObject* _self, PyObject* _hyperx) {
+  CalculatorObject* self = reinterpret_cast<CalculatorObject*>(_self);
+  Hyperx hyperx;
+  if (!fromPython(_hyperx, &hyperx)) {
+    return nullptr;
+  }
+  f64 cost;
+  try {
+    cost = self->calc->cost(hyperx);
+  } catch (std::exception& ex) {
+    PyErr_SetString(PyExc_ValueError, ex.what());
+    return nullptr;
+  }
+  return PyFloat_FromDouble(cost);
+}
+
+PyObject* Calculator_extFields(PyObject* _self, PyObject* /*_unused*/) {
+  CalculatorObject* self = reinterpret_cast<CalculatorObject*>(_self);
+  const std::vector<std::string>& fields = self->calc->extFields();
+  PyObject* list = PyList_New(fields.size());
+  if (list == nullptr) {
+    return nullptr;
+  }
+  for (u64 idx = 0; idx < fields.size(); idx++) {
+    PyObject* field = PyUnicode_FromString(fields.at(idx).c_str());
+    if (field == nullptr) {
+      Py_DECREF(list);
+      return nullptr;
+    }
+    PyList_SET_ITEM(list, idx, field);
+  }
+  return list;
+}
+
+PyObject* Calculator_extValues(PyObject* _self, PyObject* _hyperx) {
+  CalculatorObject* self = reinterpret_cast<CalculatorObject*>(_self);
+  Hyperx hyperx;
+  if (!fromPython(_hyperx, &hyperx)) {
+    return nullptr;
+  }
+  std::unordered_map<std::string, std::string> values;
+  try {
+    values = self->calc->extValues(hyperx);
+  } catch (std::exception& ex) {
+    PyErr_SetString(PyExc_ValueError, ex.what());
+    return nullptr;
+  }
+  PyObject* dict = PyDict_New();
+  if (dict == nullptr) {
+    return nullptr;
+  }
+  for (const auto& kv : values) {
+    PyObject* value = PyUnicode_FromString(kv.second.c_str());
+    if ((value == nullptr) ||
+        (PyDict_SetItemString(dict, kv.first.c_str(), value) < 0)) {
+      Py_XDECREF(value);
+      Py_DECREF(dict);
+      return nullptr;
+    }
+    Py_DECREF(value);
+  }
+  return dict;
+}
+
+PyMethodDef kCalculatorMethods[] = {
+    {"cost", Calculator_cost, METH_O, "computes the cost of a Hyperx"},
+    {"ext_fields", Calculator_extFields, METH_NOARGS,
+     "names of the extension fields"},
+    {"ext_values", Calculator_extValues, METH_O,
+     "extension values of a Hyperx as a dict"},
+    {nullptr, nullptr, 0, nullptr}};
+
+PyTypeObject CalculatorType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+/*
+ * hyperxsearch.Engine
+ */
+struct EngineObject {
+  PyObject_HEAD
+  Engine* engine;
+  PyObject* calculator;  // CalculatorObject that owns the cost function
+  bool running;
+};
+
+PyObject* Engine_new(PyTypeObject* _type, PyObject* _args, PyObject* _kwds) {
+  static const char* kwlist[] = {
+      "min_dimensions", "max_dimensions", "min_radix", "max_radix",
+      "min_concentration", "max_concentration", "min_terminals",
+      "max_terminals", "min_bandwidth", "max_bandwidth", "max_width",
+      "max_weight", "fixed_width", "fixed_weight", "max_results", "calculator",
+      "time_limit", "node_limit", nullptr};
+  // defaults match the command line interface
+  unsigned long long min_dimensions = 1;
+  unsigned long long max_dimensions = 4;
+  unsigned long long min_radix = 2;
+  unsigned long long max_radix = 64;
+  unsigned long long min_concentration = 1;
+  unsigned long long max_concentration = U32_MAX - 1;
+  unsigned long long min_terminals = 32768;
+  unsigned long long max_terminals = 0;
+  f64 min_bandwidth = 0.5;
+  f64 max_bandwidth = F64_POS_INF;
+  unsigned long long max_width = U32_MAX - 1;
+  unsigned long long max_weight = U32_MAX - 1;
+  int fixed_width = 0;
+  int fixed_weight = 0;
+  unsigned long long max_results = 10;
+  PyObject* calculator = nullptr;
+  f64 time_limit = 0.0;
+  unsigned long long node_limit = 0;
+  if (!PyArg_ParseTupleAndKeywords(
+          _args, _kwds, "|$KKKKKKKKddKKppKOdK", const_cast<char**>(kwlist),
+          &min_dimensions, &max_dimensions, &min_radix, &max_radix,
+          &min_concentration, &max_concentration, &min_terminals,
+          &max_terminals, &min_bandwidth, &max_bandwidth, &max_width,
+          &max_weight, &fixed_width, &fixed_weight, &max_results,
+          &calculator, &time_limit, &node_limit)) {
+    return nullptr;
+  }
+  if (max_terminals == 0) {
+    max_terminals = min_terminals * 2;
+  }
+
+  // the calculator may be given as an object or by name
+  if (calculator == nullptr) {
+    calculator = PyObject_CallNoArgs(reinterpret_cast<PyObject*>(
+        &CalculatorType));
+  } else if (PyUnicode_Check(calculator)) {
+    calculator = PyObject_CallOneArg(
+        reinterpret_cast<PyObject*>(&CalculatorType), calculator);
+  } else if (PyObject_TypeCheck(calculator, &CalculatorType)) {
+    Py_INCREF(calculator);
+  } else {
+    PyErr_SetString(PyExc_TypeError,
+                    "calculator must be a Calculator or a calculator name");
+    return nullptr;
+  }
+  if (calculator == nullptr) {
+    return nullptr;
+  }
+
+  Engine* engine = nullptr;
+  try {
+    engine = CalculatorFactory::createEngine(
+        min_dimensions, max_dimensions, min_radix, max_radix,
+        min_concentration, max_concentration, min_terminals, max_terminals,
+        min_bandwidth, max_bandwidth, max_width, max_weight, fixed_width,
+        fixed_weight, max_results,
+        reinterpret_cast<CalculatorObject*>(calculator)->calc);
+    engine->setBudget(time_limit, node_limit);
+  } catch (std::exception& ex) {
+    delete engine;
+    Py_DECREF(calculator);
+    PyErr_SetString(PyExc_ValueError, ex.what());
+    return nullptr;
+  }
+
+  EngineObject* self = reinterpret_cast<EngineObject*>(_type->tp_alloc(_type, 0));
+  if (self == nullptr) {
+    delete engine;
+    Py_DECREF(calculator);
+    return nullptr;
+  }
+  self->engine = engine;
+  self->calculator = calculator;
+  self->running = false;
+  return reinterpret_cast<PyObject*>(self);
+}
+
+void Engine_dealloc(PyObject* _self) {
+  EngineObject* self = reinterpret_cast<EngineObject*>(_self);
+  delete self->engine;
+  Py_XDECREF(self->calculator);
+  Py_TYPE(_self)->tp_free(_self);
+}
+
+PyObject* Engine_run(PyObject* _self, PyObject* /*_unused*/) {
+  EngineObject* self = reinterpret_cast<EngineObject*>(_self);
+  if (self->running) {
+    PyErr_SetString(PyExc_RuntimeError, "engine is already running");
+    return nullptr;
+  }
+  self->running = true;
+  bool failed = false;
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    self->engine->run();
+  } catch (std::exception& ex) {
+    failed = true;
+    error = ex.what();
+  }
+  Py_END_ALLOW_THREADS
+  self->running = false;
+  if (failed) {
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
+PyObject* Engine_results(PyObject* _self, PyObject* /*_unused*/) {
+  EngineObject* self = reinterpret_cast<EngineObject*>(_self);
+  if (self->running) {
+    PyErr_SetString(PyExc_RuntimeError, "engine is running");
+    return nullptr;
+  }
+  const std::deque<Hyperx>& results = self->engine->results();
+  PyObject* list = PyList_New(results.size());
+  if (list == nullptr) {
+    return nullptr;
+  }
+  for (u64 idx = 0; idx < results.size(); idx++) {
+    PyObject* hyperx = toPython(results.at(idx));
+    if (hyperx == nullptr) {
+      Py_DECREF(list);
+      return nullptr;
+    }
+    PyList_SET_ITEM(list, idx, hyperx);
+  }
+  return list;
+}
+
+PyObject* Engine_coverage(PyObject* _self, PyObject* /*_unused*/) {
+  EngineObject* self = reinterpret_cast<EngineObject*>(_self);
+  if (self->running) {
+    PyErr_SetString(PyExc_RuntimeError, "engine is running");
+    return nullptr;
+  }
+  const Coverage& coverage = self->engine->coverage();
+  return Py_BuildValue("{s:O,s:K,s:K,s:K,s:d}", "complete",
+                       coverage.complete ? Py_True : Py_False, "nodes",
+                       static_cast<unsigned long long>(coverage.nodes),
+                       "regions",
+                       static_cast<unsigned long long>(coverage.regions),
+                       "regions_searched",
+                       static_cast<unsigned long long>(
+                           coverage.regions_searched),
+                       "seconds", coverage.seconds);
+}
+
+PyObject* Engine_count(PyObject* _self, PyObject* /*_unused*/) {
+  EngineObject* self = reinterpret_cast<EngineObject*>(_self);
+  if (self->running) {
+    PyErr_SetString(PyExc_RuntimeError, "engine is already running");
+    return nullptr;
+  }
+  self->running = true;
+  bool failed = false;
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    self->engine->count();
+  } catch (std::exception& ex) {
+    failed = true;
+    error = ex.what();
+  }
+  Py_END_ALLOW_THREADS
+  self->running = false;
+  if (failed) {
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+    return nullptr;
+  }
+  const std::vector<SpaceCount>& counts = self->engine->counts();
+  PyObject* list = PyList_New(counts.size());
+  if (list == nullptr) {
+    return nullptr;
+  }
+  for (u64 idx = 0; idx < counts.size(); idx++) {
+    const SpaceCount& count = counts.at(idx);
+    PyObject* dict = Py_BuildValue(
+        "{s:K,s:K,s:K,s:K,s:K}", "dimensions",
+        static_cast<unsigned long long>(count.dimensions), "regions",
+        static_cast<unsigned long long>(count.regions), "stage3s",
+        static_cast<unsigned long long>(count.stage3s), "nodes",
+        static_cast<unsigned long long>(count.nodes), "feasible",
+        static_cast<unsigned long long>(count.feasible));
+    if (dict == nullptr) {
+      Py_DECREF(list);
+      return nullptr;
+    }
+    PyList_SET_ITEM(list, idx, dict);
+  }
+  return list;
+}
+
+PyObject* Engine_calculator(PyObject* _self, void* /*_closure*/) {
+  EngineObject* self = reinterpret_cast<EngineObject*>(_self);
+  Py_INCREF(self->calculator);
+  return self->calculator;
+}
+
+PyMethodDef kEngineMethods[] = {
+    {"run", Engine_run, METH_NOARGS,
+     "runs the search (releases the GIL while searching)"},
+    {"results", Engine_results, METH_NOARGS,
+     "the results of the last run as a list of Hyperx, best first"},
+    {"count", Engine_count, METH_NOARGS,
+     "counts the search space per dimension count without searching"},
+    {"coverage", Engine_coverage, METH_NOARGS,
+     "how much of the search space the last run covered"},
+    {nullptr, nullptr, 0, nullptr}};
+
+PyGetSetDef kEngineGetSet[] = {
+    {"calculator", Engine_calculator, nullptr, "the cost calculator",
+     nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}};
+
+PyTypeObject EngineType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+PyModuleDef kModule = {PyModuleDef_HEAD_INIT, "hyperxsearch",
+                       "Search HyperX topologies for optimal solutions.", -1,
+                       nullptr};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_hyperxsearch() {
+  CalculatorType.tp_name = "hyperxsearch.Calculator";
+  CalculatorType.tp_doc = "A cost calculator created by name.";
+  CalculatorType.tp_basicsize = sizeof(CalculatorObject);
+  CalculatorType.tp_flags = Py_TPFLAGS_DEFAULT;
+  CalculatorType.tp_new = Calculator_new;
+  CalculatorType.tp_dealloc = Calculator_dealloc;
+  CalculatorType.tp_methods = kCalculatorMethods;
+  if (PyType_Ready(&CalculatorType) < 0) {
+    return nullptr;
+  }
+
+  EngineType.tp_name = "hyperxsearch.Engine";
+  EngineType.tp_doc = "The HyperX search engine.";
+  EngineType.tp_basicsize = sizeof(EngineObject);
+  EngineType.tp_flags = Py_TPFLAGS_DEFAULT;
+  EngineType.tp_new = Engine_new;
+  EngineType.tp_dealloc = Engine_dealloc;
+  EngineType.tp_methods = kEngineMethods;
+  EngineType.tp_getset = kEngineGetSet;
+  if (PyType_Ready(&EngineType) < 0) {
+    return nullptr;
+  }
+
+  HyperxType = PyStructSequence_NewType(&kHyperxDesc);
+  if (HyperxType == nullptr) {
+    return nullptr;
+  }
+
+  PyObject* module = PyModule_Create(&kModule);
+  if (module == nullptr) {
+    return nullptr;
+  }
+  if ((PyModule_AddObjectRef(module, "Hyperx",
+                             reinterpret_cast<PyObject*>(HyperxType)) < 0) ||
+      (PyModule_AddObjectRef(module, "Calculator",
+                             reinterpret_cast<PyObject*>(&CalculatorType)) <
+       0) ||
+      (PyModule_AddObjectRef(module, "Engine",
+                             reinterpret_cast<PyObject*>(&EngineType)) < 0)) {
+    Py_DECREF(module);
+    return nullptr;
+  }
+  return module;
+}
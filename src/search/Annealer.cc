@@ -0,0 +1,415 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Annealer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+// the temperature decays geometrically from the first to the last step. it is
+//  relative to the current energy so it is independent of the cost scale.
+static const f64 kStartTemperature = 0.1;
+static const f64 kEndTemperature = 1e-4;
+
+// chains return to their best configuration every this many steps
+static const u64 kRestartInterval = 10000;
+
+// orders configurations by cost and then by their parameters so that merging
+//  chains is deterministic
+static bool ordered(const Hyperx& _lhs, const Hyperx& _rhs) {
+  if (_lhs.cost != _rhs.cost) {
+    return _lhs.cost < _rhs.cost;
+  }
+  if (_lhs.dimensions != _rhs.dimensions) {
+    return _lhs.dimensions < _rhs.dimensions;
+  }
+  if (_lhs.widths != _rhs.widths) {
+    return _lhs.widths < _rhs.widths;
+  }
+  if (_lhs.weights != _rhs.weights) {
+    return _lhs.weights < _rhs.weights;
+  }
+  return _lhs.concentration < _rhs.concentration;
+}
+
+static bool same(const Hyperx& _lhs, const Hyperx& _rhs) {
+  return (_lhs.dimensions == _rhs.dimensions) && (_lhs.widths == _rhs.widths) &&
+         (_lhs.weights == _rhs.weights) &&
+         (_lhs.concentration == _rhs.concentration);
+}
+
+// puts widths in non-decreasing and weights in non-increasing order, the same
+//  canonical form the engine searches
+static void canonicalize(Hyperx* _hyperx) {
+  std::sort(_hyperx->widths.begin(), _hyperx->widths.end());
+  std::sort(_hyperx->weights.begin(), _hyperx->weights.end(),
+            [](u64 _a, u64 _b) { return _a > _b; });
+}
+
+// moves a value up or down by a random step scaled to its magnitude, staying
+//  within [min, max]
+static u64 step(std::mt19937_64* _rng, u64 _value, u64 _min, u64 _max) {
+  if (_max <= _min) {
+    return _min;
+  }
+  _value = std::min(std::max(_value, _min), _max);
+  u64 size = 1 + ((*_rng)() % std::max<u64>(1, _value / 8));
+  if ((*_rng)() & 1) {
+    _value = (_max - _value < size) ? _max : _value + size;
+  } else {
+    _value = (_value - _min < size) ? _min : _value - size;
+  }
+  return _value;
+}
+
+Annealer::Annealer(const Engine* _engine, u64 _chains, u64 _steps, u64 _seed)
+    : engine_(_engine),
+      chains_(_chains),
+      steps_(_steps),
+      seed_(_seed),
+      evaluations_(0) {
+  if (chains_ == 0) {
+    throw std::runtime_error("the number of chains must be positive");
+  }
+  if (engine_->minDimensions() == 0 ||
+      engine_->minDimensions() > engine_->maxDimensions()) {
+    throw std::runtime_error("invalid dimension limits");
+  }
+}
+
+Annealer::~Annealer() {}
+
+void Annealer::run() {
+  results_.clear();
+  evaluations_ = 0;
+
+  // run the chains on as many threads as the machine has
+  std::vector<Chain> chains(chains_);
+  std::atomic<u64> next(0);
+  u64 threads = std::min<u64>(
+      chains_, std::max<u64>(1, std::thread::hardware_concurrency()));
+  std::vector<std::thread> workers;
+  for (u64 thread = 0; thread < threads; thread++) {
+    workers.emplace_back([this, &chains, &next]() {
+      for (u64 index = next++; index < chains_; index = next++) {
+        anneal(index, &chains.at(index));
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  // merge the chains into a single top-K
+  std::vector<Hyperx> all;
+  for (const Chain& chain : chains) {
+    all.insert(all.end(), chain.best.begin(), chain.best.end());
+    evaluations_ += chain.evaluations;
+  }
+  std::sort(all.begin(), all.end(), ordered);
+  for (const Hyperx& hyperx : all) {
+    if (results_.size() == engine_->maxResults()) {
+      break;
+    }
+    if (results_.empty() || !same(results_.back(), hyperx)) {
+      results_.push_back(hyperx);
+    }
+  }
+}
+
+const std::deque<Hyperx>& Annealer::results() const {
+  return results_;
+}
+
+u64 Annealer::evaluations() const {
+  return evaluations_;
+}
+
+void Annealer::anneal(u64 _index, Chain* _chain) const {
+  std::seed_seq seq({seed_, _index});
+  _chain->rng.seed(seq);
+  _chain->evaluations = 0;
+
+  // spread the chains across the dimension range
+  u64 dimensions = engine_->minDimensions() +
+                   (_index % (engine_->maxDimensions() -
+                              engine_->minDimensions() + 1));
+  initialize(_chain, dimensions);
+
+  bool feasible = engine_->evaluate(&_chain->current);
+  _chain->evaluations++;
+  _chain->current_violation = feasible ? 0.0 : violation(_chain->current);
+  if (feasible) {
+    record(_chain, _chain->current);
+  }
+
+  std::uniform_real_distribution<f64> uniform(0.0, 1.0);
+  Hyperx next;
+  for (u64 iter = 0; iter < steps_; iter++) {
+    f64 temperature =
+        kStartTemperature *
+        std::pow(kEndTemperature / kStartTemperature,
+                 static_cast<f64>(iter) / std::max<u64>(1, steps_ - 1));
+
+    // periodically return to the best configuration found so far
+    if ((iter > 0) && ((iter % kRestartInterval) == 0) &&
+        !_chain->best.empty()) {
+      _chain->current = _chain->best.front();
+      _chain->current_violation = 0.0;
+      feasible = true;
+    }
+
+    next = _chain->current;
+    mutate(_chain, &next);
+    bool next_feasible = engine_->evaluate(&next);
+    _chain->evaluations++;
+    f64 next_violation = next_feasible ? 0.0 : violation(next);
+
+    // feasible configurations always beat infeasible ones, otherwise compare
+    //  relative cost or relative limit violation
+    f64 delta;
+    if (next_feasible && feasible) {
+      f64 scale = std::abs(_chain->current.cost);
+      delta = (next.cost - _chain->current.cost) / ((scale > 0.0) ? scale : 1.0);
+    } else if (next_feasible) {
+      delta = F64_NEG_INF;
+    } else if (feasible) {
+      delta = next_violation;
+    } else {
+      delta = next_violation - _chain->current_violation;
+    }
+
+    if ((delta <= 0.0) ||
+        (uniform(_chain->rng) < std::exp(-delta / temperature))) {
+      std::swap(_chain->current, next);
+      _chain->current_violation = next_violation;
+      feasible = next_feasible;
+      if (feasible) {
+        record(_chain, _chain->current);
+      }
+    }
+  }
+}
+
+void Annealer::initialize(Chain* _chain, u64 _dimensions) const {
+  Hyperx& hyperx = _chain->current;
+  hyperx.dimensions = _dimensions;
+
+  // start at random widths around the one that reaches the minimum terminal
+  //  count with a moderate concentration
+  u64 max_width = std::min(engine_->maxWidth(), engine_->maxRadix());
+  u64 concentration = std::max<u64>(
+      engine_->minConcentration(),
+      std::min(engine_->maxConcentration(), engine_->maxRadix() / 4));
+  f64 routers = std::ceil(static_cast<f64>(engine_->minTerminals()) /
+                          std::max<u64>(1, concentration));
+  u64 width = static_cast<u64>(
+      std::ceil(std::pow(routers, 1.0 / static_cast<f64>(_dimensions))));
+  width = std::min(std::max<u64>(2, width), std::max<u64>(2, max_width));
+
+  hyperx.widths.assign(_dimensions, width);
+  hyperx.weights.assign(_dimensions, 1);
+  if (!engine_->fixedWidth()) {
+    for (u64 dim = 0; dim < _dimensions; dim++) {
+      hyperx.widths.at(dim) = std::min(
+          max_width, 2 + (_chain->rng() % (2 * width - 1)));
+    }
+  }
+  canonicalize(&hyperx);
+  concentrate(&hyperx);
+  balance(&hyperx);
+}
+
+void Annealer::mutate(Chain* _chain, Hyperx* _next) const {
+  std::mt19937_64* rng = &_chain->rng;
+  u64 max_width = std::max<u64>(
+      2, std::min(engine_->maxWidth(), engine_->maxRadix()));
+  u64 max_weight = std::max<u64>(
+      1, std::min(engine_->maxWeight(), engine_->maxRadix()));
+  u64 max_concentration = std::max(
+      engine_->minConcentration(),
+      std::min(engine_->maxConcentration(), engine_->maxRadix()));
+  u64 dim = (*rng)() % _next->dimensions;
+
+  u64 move = (*rng)() % 6;
+  switch (move) {
+    case 0:
+    case 3: {
+      // change a width, the coupled variant also adjusts the concentration to
+      //  keep the terminal count near the target and the weights to just meet
+      //  the minimum bandwidth
+      u64 width = step(rng, _next->widths.at(dim), 2, max_width);
+      if (engine_->fixedWidth()) {
+        _next->widths.assign(_next->dimensions, width);
+      } else {
+        _next->widths.at(dim) = width;
+      }
+      canonicalize(_next);
+      if (move == 3) {
+        concentrate(_next);
+        balance(_next);
+      }
+      break;
+    }
+    case 1: {
+      // change a weight
+      u64 weight = step(rng, _next->weights.at(dim), 1, max_weight);
+      if (engine_->fixedWeight()) {
+        _next->weights.assign(_next->dimensions, weight);
+      } else {
+        _next->weights.at(dim) = weight;
+      }
+      canonicalize(_next);
+      break;
+    }
+    case 2: {
+      // change the concentration
+      _next->concentration =
+          step(rng, _next->concentration, engine_->minConcentration(),
+               max_concentration);
+      break;
+    }
+    case 4: {
+      // change the concentration and rebalance the weights to it
+      _next->concentration =
+          step(rng, _next->concentration, engine_->minConcentration(),
+               max_concentration);
+      balance(_next);
+      break;
+    }
+    case 5: {
+      // move size between two dimensions, keeping the router count roughly
+      //  the same, then rebalance
+      u64 other = (*rng)() % _next->dimensions;
+      if (other == dim || engine_->fixedWidth()) {
+        break;
+      }
+      u64 before = _next->widths.at(dim);
+      u64 after = step(rng, before, 2, max_width);
+      u64 scaled = (_next->widths.at(other) * before + after - 1) / after;
+      _next->widths.at(dim) = after;
+      _next->widths.at(other) =
+          std::min(max_width, std::max<u64>(2, scaled));
+      canonicalize(_next);
+      concentrate(_next);
+      balance(_next);
+      break;
+    }
+  }
+}
+
+void Annealer::concentrate(Hyperx* _hyperx) const {
+  u64 routers = 1;
+  for (u64 width : _hyperx->widths) {
+    if (__builtin_mul_overflow(routers, width, &routers)) {
+      routers = U64_MAX;
+      break;
+    }
+  }
+  u64 concentration =
+      (engine_->minTerminals() / routers) +
+      (((engine_->minTerminals() % routers) == 0) ? 0 : 1);
+  concentration = std::min(concentration, std::min(
+      engine_->maxConcentration(), engine_->maxRadix()));
+  concentration = std::max(engine_->minConcentration(), concentration);
+  _hyperx->concentration = concentration;
+}
+
+void Annealer::balance(Hyperx* _hyperx) const {
+  u64 max_weight = std::max<u64>(
+      1, std::min(engine_->maxWeight(), engine_->maxRadix()));
+  u64 fixed = 1;
+  for (u64 dim = 0; dim < _hyperx->dimensions; dim++) {
+    f64 weight = std::ceil((2.0 * _hyperx->concentration *
+                            engine_->minBandwidth()) /
+                           _hyperx->widths.at(dim));
+    u64 clamped = static_cast<u64>(
+        std::min(std::max(weight, 1.0), static_cast<f64>(max_weight)));
+    _hyperx->weights.at(dim) = clamped;
+    fixed = std::max(fixed, clamped);
+  }
+  if (engine_->fixedWeight()) {
+    _hyperx->weights.assign(_hyperx->dimensions, fixed);
+  }
+  canonicalize(_hyperx);
+}
+
+f64 Annealer::violation(const Hyperx& _hyperx) const {
+  f64 violation = 0.0;
+  f64 terminals = static_cast<f64>(_hyperx.terminals);
+  if (terminals < engine_->minTerminals()) {
+    violation += (engine_->minTerminals() - terminals) /
+                 engine_->minTerminals();
+  } else if (terminals > engine_->maxTerminals()) {
+    violation += (terminals - engine_->maxTerminals()) /
+                 std::max<u64>(1, engine_->maxTerminals());
+  }
+  f64 radix = static_cast<f64>(_hyperx.router_radix);
+  if (radix < engine_->minRadix()) {
+    violation += (engine_->minRadix() - radix) / engine_->minRadix();
+  } else if (radix > engine_->maxRadix()) {
+    violation += (radix - engine_->maxRadix()) /
+                 std::max<u64>(1, engine_->maxRadix());
+  }
+  for (f64 bisection : _hyperx.bisections) {
+    if (bisection < engine_->minBandwidth()) {
+      violation += (engine_->minBandwidth() - bisection) /
+                   engine_->minBandwidth();
+    } else if (bisection > engine_->maxBandwidth()) {
+      violation += (bisection - engine_->maxBandwidth()) /
+                   engine_->maxBandwidth();
+    }
+  }
+  return violation;
+}
+
+void Annealer::record(Chain* _chain, const Hyperx& _hyperx) const {
+  std::vector<Hyperx>& best = _chain->best;
+  if (engine_->maxResults() == 0) {
+    return;
+  }
+  if ((best.size() == engine_->maxResults()) &&
+      !ordered(_hyperx, best.back())) {
+    return;
+  }
+  for (const Hyperx& other : best) {
+    if (same(other, _hyperx)) {
+      return;
+    }
+  }
+  best.insert(std::upper_bound(best.begin(), best.end(), _hyperx, ordered),
+              _hyperx);
+  if (best.size() > engine_->maxResults()) {
+    best.pop_back();
+  }
+}
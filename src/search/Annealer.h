@@ -0,0 +1,81 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_ANNEALER_H_
+#define SEARCH_ANNEALER_H_
+
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+
+// A simulated annealing search over (widths, weights, concentration) for
+//  spaces too large for the exhaustive engine. The engine supplies the limits,
+//  the feasibility checks, and the cost function. Each chain is independent and
+//  seeded from the annealer's seed so results are reproducible regardless of
+//  thread scheduling.
+class Annealer {
+ public:
+  Annealer(const Engine* _engine, u64 _chains, u64 _steps, u64 _seed);
+  ~Annealer();
+
+  void run();
+  const std::deque<Hyperx>& results() const;
+  u64 evaluations() const;
+
+ private:
+  struct Chain {
+    std::mt19937_64 rng;
+    Hyperx current;
+    f64 current_violation;
+    std::vector<Hyperx> best;  // sorted top-K of this chain
+    u64 evaluations;
+  };
+
+  void anneal(u64 _index, Chain* _chain) const;
+  void initialize(Chain* _chain, u64 _dimensions) const;
+  void mutate(Chain* _chain, Hyperx* _next) const;
+  void concentrate(Hyperx* _hyperx) const;
+  void balance(Hyperx* _hyperx) const;
+  f64 violation(const Hyperx& _hyperx) const;
+  void record(Chain* _chain, const Hyperx& _hyperx) const;
+
+  const Engine* engine_;
+  const u64 chains_;
+  const u64 steps_;
+  const u64 seed_;
+
+  std::deque<Hyperx> results_;
+  u64 evaluations_;
+};
+
+#endif  // SEARCH_ANNEALER_H_
@@ -46,3 +46,10 @@ std::unordered_map<std::string, std::string> Calculator::extValues(
     const Hyperx& /*_hyperx*/) const {
   return kEmptyValues;
 }
+
+std::unordered_map<std::string, std::string> Calculator::networkExtValues(
+    const Network& /*_network*/) const {
+  return kEmptyValues;
+}
+
+void Calculator::analyze(const std::deque<Hyperx>& /*_results*/) {}
@@ -31,6 +31,7 @@
 #ifndef SEARCH_CALCULATOR_H_
 #define SEARCH_CALCULATOR_H_
 
+#include <deque>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -48,6 +49,15 @@ class Calculator : public CostFunction {
   virtual std::unordered_map<std::string, std::string> extValues(
       const Hyperx& _hyperx) const;
 
+  // the extension values of a network of any topology family, fields that
+  //  only apply to HyperX are left out. the default has none.
+  virtual std::unordered_map<std::string, std::string> networkExtValues(
+      const Network& _network) const;
+
+  // called with the final results before their extension values are
+  //  requested, allowing expensive metrics to be computed once in bulk
+  virtual void analyze(const std::deque<Hyperx>& _results);
+
  private:
   static const std::vector<std::string> kEmptyFields;
   static const std::unordered_map<std::string, std::string> kEmptyValues;
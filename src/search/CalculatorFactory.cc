@@ -30,16 +30,93 @@
  */
 #include "search/CalculatorFactory.h"
 
-#include <cassert>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
 
+#include "search/CostExpression.h"
+#include "search/GraphAnalytics.h"
+#include "search/Packaging.h"
+#include "search/Resilience.h"
 #include "search/RouterChannelCount.h"
+#include "search/Throughput.h"
+#include "strop/strop.h"
 
 Calculator* CalculatorFactory::createCalculator(const std::string& _type) {
-  if (_type == "router_channel_count") {
+  // the type is a name optionally followed by settings
+  //  (e.g., "name:key=value,key=value")
+  std::string name = _type.substr(0, _type.find(':'));
+  std::unordered_map<std::string, std::string> settings;
+  if (name.size() < _type.size()) {
+    for (const std::string& setting :
+         strop::split(_type.substr(name.size() + 1), ',')) {
+      size_t equals = setting.find('=');
+      if (equals == std::string::npos) {
+        throw std::runtime_error("invalid cost calculator setting: " +
+                                 setting);
+      }
+      settings[setting.substr(0, equals)] = setting.substr(equals + 1);
+    }
+  }
+
+  if (name == "router_channel_count") {
+    if (!settings.empty()) {
+      throw std::runtime_error("router_channel_count has no settings");
+    }
     return new RouterChannelCount();
+  } else if (name == "graph_analytics") {
+    return new GraphAnalytics(settings);
+  } else if (name == "resilience") {
+    return new Resilience(settings);
+  } else if (name == "throughput") {
+    return new Throughput(settings);
+  } else if (name == "packaging") {
+    return new Packaging(settings);
+  } else {
+    throw std::runtime_error("unknown cost calculator: " + name);
+  }
+}
+
+Engine* CalculatorFactory::createEngine(
+    u64 _min_dimensions, u64 _max_dimensions, u64 _min_radix, u64 _max_radix,
+    u64 _min_concentration, u64 _max_concentration, u64 _min_terminals,
+    u64 _max_terminals, f64 _min_bandwidth, f64 _max_bandwidth,
+    u64 _max_width, u64 _max_weight, bool _fixed_width, bool _fixed_weight,
+    u64 _max_results, const Calculator* _calculator) {
+  const std::type_info& type = typeid(*_calculator);
+  if (type == typeid(RouterChannelCount)) {
+    return new CostEngine<RouterChannelCount>(
+        _min_dimensions, _max_dimensions, _min_radix, _max_radix,
+        _min_concentration, _max_concentration, _min_terminals, _max_terminals,
+        _min_bandwidth, _max_bandwidth, _max_width, _max_weight, _fixed_width,
+        _fixed_weight, _max_results,
+        static_cast<const RouterChannelCount*>(_calculator));
+  } else if (type == typeid(Throughput)) {
+    return new CostEngine<Throughput>(
+        _min_dimensions, _max_dimensions, _min_radix, _max_radix,
+        _min_concentration, _max_concentration, _min_terminals, _max_terminals,
+        _min_bandwidth, _max_bandwidth, _max_width, _max_weight, _fixed_width,
+        _fixed_weight, _max_results,
+        static_cast<const Throughput*>(_calculator));
+  } else if (type == typeid(Packaging)) {
+    return new CostEngine<Packaging>(
+        _min_dimensions, _max_dimensions, _min_radix, _max_radix,
+        _min_concentration, _max_concentration, _min_terminals, _max_terminals,
+        _min_bandwidth, _max_bandwidth, _max_width, _max_weight, _fixed_width,
+        _fixed_weight, _max_results,
+        static_cast<const Packaging*>(_calculator));
+  } else if (type == typeid(CostExpression)) {
+    return new CostEngine<CostExpression>(
+        _min_dimensions, _max_dimensions, _min_radix, _max_radix,
+        _min_concentration, _max_concentration, _min_terminals, _max_terminals,
+        _min_bandwidth, _max_bandwidth, _max_width, _max_weight, _fixed_width,
+        _fixed_weight, _max_results,
+        static_cast<const CostExpression*>(_calculator));
   } else {
-    fprintf(stderr, "unknown cost calculator: %s\n", _type.c_str());
-    assert(false);
-    return nullptr;
+    return new Engine(
+        _min_dimensions, _max_dimensions, _min_radix, _max_radix,
+        _min_concentration, _max_concentration, _min_terminals, _max_terminals,
+        _min_bandwidth, _max_bandwidth, _max_width, _max_weight, _fixed_width,
+        _fixed_weight, _max_results, _calculator);
   }
 }
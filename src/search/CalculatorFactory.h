@@ -33,11 +33,22 @@
 
 #include <string>
 
+#include "prim/prim.h"
 #include "search/Calculator.h"
+#include "search/Engine.h"
 
 class CalculatorFactory {
  public:
   static Calculator* createCalculator(const std::string& _type);
+
+  // creates an engine specialized for the type of the calculator when it is
+  //  a built-in one, otherwise an engine calling it through CostFunction
+  static Engine* createEngine(
+      u64 _min_dimensions, u64 _max_dimensions, u64 _min_radix,
+      u64 _max_radix, u64 _min_concentration, u64 _max_concentration,
+      u64 _min_terminals, u64 _max_terminals, f64 _min_bandwidth,
+      f64 _max_bandwidth, u64 _max_width, u64 _max_weight, bool _fixed_width,
+      bool _fixed_weight, u64 _max_results, const Calculator* _calculator);
 };
 
 #endif  // SEARCH_CALCULATORFACTORY_H_
@@ -0,0 +1,579 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/CostExpression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+struct Function {
+  const char* name;
+  u32 min_args;
+  u32 max_args;
+};
+
+// products where zero times infinity is zero
+f64 multiply(f64 _a, f64 _b) {
+  return ((_a == 0.0) || (_b == 0.0)) ? 0.0 : _a * _b;
+}
+
+}  // namespace
+
+// a recursive descent parser with the usual precedence:
+//  sum     = product (('+' | '-') product)*
+//  product = unary (('*' | '/') unary)*
+//  unary   = '-' unary | power
+//  power   = primary ('^' unary)?
+//  primary = number | name | name '(' sum (',' sum)* ')' | '(' sum ')'
+class CostExpression::Parser {
+ public:
+  Parser(CostExpression* _expression, const std::string& _text,
+         const std::unordered_map<std::string, f64>& _constants)
+      : expression_(_expression), text_(_text), constants_(_constants),
+        pos_(0) {}
+
+  u32 parse() {
+    u32 node = sum();
+    skip();
+    if (pos_ != text_.size()) {
+      throw error("unexpected '" + text_.substr(pos_, 1) + "'");
+    }
+    if (expression_->nodes_.at(node).vector) {
+      throw error("per dimension values must be reduced to a scalar");
+    }
+    return node;
+  }
+
+ private:
+  u32 sum() {
+    u32 node = product();
+    while (true) {
+      if (accept('+')) {
+        node = expression_->add(Op::kAdd, node, product());
+      } else if (accept('-')) {
+        node = expression_->add(Op::kSubtract, node, product());
+      } else {
+        return node;
+      }
+    }
+  }
+
+  u32 product() {
+    u32 node = unary();
+    while (true) {
+      if (accept('*')) {
+        node = expression_->add(Op::kMultiply, node, unary());
+      } else if (accept('/')) {
+        node = expression_->add(Op::kDivide, node, unary());
+      } else {
+        return node;
+      }
+    }
+  }
+
+  u32 unary() {
+    if (accept('-')) {
+      return expression_->add(Op::kNegate, unary(), 0);
+    }
+    return power();
+  }
+
+  u32 power() {
+    u32 node = primary();
+    if (accept('^')) {
+      node = expression_->add(Op::kPower, node, unary());
+    }
+    return node;
+  }
+
+  u32 primary() {
+    skip();
+    if (accept('(')) {
+      u32 node = sum();
+      expect(')');
+      return node;
+    }
+    if ((pos_ < text_.size()) &&
+        (std::isdigit(text_[pos_]) || (text_[pos_] == '.'))) {
+      const char* start = text_.c_str() + pos_;
+      char* end;
+      f64 value = std::strtod(start, &end);
+      pos_ += end - start;
+      return constant(value);
+    }
+
+    u64 start = pos_;
+    while ((pos_ < text_.size()) &&
+           (std::isalnum(text_[pos_]) || (text_[pos_] == '_'))) {
+      pos_++;
+    }
+    if (pos_ == start) {
+      throw error(pos_ < text_.size() ?
+                  "unexpected '" + text_.substr(pos_, 1) + "'" :
+                  "unexpected end");
+    }
+    std::string name = text_.substr(start, pos_ - start);
+    if (accept('(')) {
+      return call(name);
+    }
+    return variable(name);
+  }
+
+  u32 call(const std::string& _name) {
+    static const Function kFunctions[] = {
+      {"min", 1, 2}, {"max", 1, 2}, {"sum", 1, 1}, {"prod", 1, 1},
+      {"mean", 1, 1}, {"ceil", 1, 1}, {"floor", 1, 1}, {"sqrt", 1, 1},
+      {"log2", 1, 1}, {"abs", 1, 1}};
+    const Function* function = nullptr;
+    for (const Function& candidate : kFunctions) {
+      if (_name == candidate.name) {
+        function = &candidate;
+      }
+    }
+    if (function == nullptr) {
+      throw error("unknown function " + _name + "()");
+    }
+
+    std::vector<u32> args = {sum()};
+    while (accept(',')) {
+      args.push_back(sum());
+    }
+    expect(')');
+    if ((args.size() < function->min_args) ||
+        (args.size() > function->max_args)) {
+      throw error("wrong number of arguments to " + _name + "()");
+    }
+
+    if (args.size() == 2) {
+      return expression_->add((_name == "min") ? Op::kMin : Op::kMax,
+                              args.at(0), args.at(1));
+    }
+    Op op;
+    bool reduction = true;
+    if ((_name == "min") || (_name == "max") || (_name == "sum") ||
+        (_name == "prod") || (_name == "mean")) {
+      op = (_name == "min")    ? Op::kMinimum
+           : (_name == "max")  ? Op::kMaximum
+           : (_name == "sum")  ? Op::kSum
+           : (_name == "prod") ? Op::kProduct
+                               : Op::kMean;
+    } else {
+      reduction = false;
+      op = (_name == "ceil")    ? Op::kCeil
+           : (_name == "floor") ? Op::kFloor
+           : (_name == "sqrt")  ? Op::kSqrt
+           : (_name == "log2")  ? Op::kLog2
+                                : Op::kAbs;
+    }
+    if (reduction && !expression_->nodes_.at(args.at(0)).vector) {
+      throw error(_name + "() needs per dimension values");
+    }
+    return expression_->add(op, args.at(0), 0);
+  }
+
+  u32 variable(const std::string& _name) {
+    static const std::unordered_map<std::string, Op> kFields = {
+      {"routers", Op::kRouters}, {"terminals", Op::kTerminals},
+      {"router_radix", Op::kRouterRadix}, {"channels", Op::kChannels},
+      {"dimensions", Op::kDimensions}, {"concentration", Op::kConcentration},
+      {"widths", Op::kWidths}, {"weights", Op::kWeights},
+      {"bisections", Op::kBisections}};
+    auto field = kFields.find(_name);
+    if (field != kFields.end()) {
+      return expression_->add(field->second, 0, 0);
+    }
+    auto constant_value = constants_.find(_name);
+    if (constant_value != constants_.end()) {
+      return constant(constant_value->second);
+    }
+    throw error("unknown name " + _name);
+  }
+
+  u32 constant(f64 _value) {
+    u32 node = expression_->add(Op::kConstant, 0, 0);
+    expression_->nodes_.at(node).value = _value;
+    return node;
+  }
+
+  void skip() {
+    while ((pos_ < text_.size()) && std::isspace(text_[pos_])) {
+      pos_++;
+    }
+  }
+
+  bool accept(char _c) {
+    skip();
+    if ((pos_ < text_.size()) && (text_[pos_] == _c)) {
+      pos_++;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char _c) {
+    if (!accept(_c)) {
+      throw error(std::string("expected '") + _c + "'");
+    }
+  }
+
+  std::runtime_error error(const std::string& _message) const {
+    return std::runtime_error("cost expression: " + _message +
+                              " at position " + std::to_string(pos_));
+  }
+
+  CostExpression* expression_;
+  const std::string& text_;
+  const std::unordered_map<std::string, f64>& constants_;
+  u64 pos_;
+};
+
+CostExpression::CostExpression(
+    const std::string& _expression,
+    const std::unordered_map<std::string, f64>& _constants)
+    : hyperx_only_(false) {
+  Parser parser(this, _expression, _constants);
+  root_ = parser.parse();
+  for (const Node& node : nodes_) {
+    hyperx_only_ |= (node.op == Op::kDimensions) ||
+                    (node.op == Op::kConcentration) ||
+                    (node.op == Op::kWidths) || (node.op == Op::kWeights);
+  }
+}
+
+CostExpression::~CostExpression() {}
+
+f64 CostExpression::cost(const Hyperx& _hyperx) const {
+  return operand(root_, _hyperx, &_hyperx, 0);
+}
+
+f64 CostExpression::networkCost(const Network& _network) const {
+  if (hyperx_only_) {
+    throw std::runtime_error(
+        "the cost expression uses fields only HyperX networks have");
+  }
+  return operand(root_, _network, nullptr, 0);
+}
+
+f64 CostExpression::lowerBound(const Hyperx& _hyperx,
+                               const std::vector<u64>& _max_weights) const {
+  // every weight is between 1 and its maximum
+  Bounds bounds;
+  bounds.hyperx = &_hyperx;
+  bounds.router_radix = {static_cast<f64>(_hyperx.concentration),
+                         static_cast<f64>(_hyperx.concentration)};
+  bounds.channels = {static_cast<f64>(_hyperx.terminals),
+                     static_cast<f64>(_hyperx.terminals)};
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    f64 width = static_cast<f64>(_hyperx.widths.at(dim));
+    f64 max_weight = static_cast<f64>(_max_weights.at(dim));
+    f64 pairs = static_cast<f64>(_hyperx.routers) * (width - 1) / 2.0;
+    bounds.router_radix.low += width - 1;
+    bounds.router_radix.high += (width - 1) * max_weight;
+    bounds.channels.low += pairs;
+    bounds.channels.high += pairs * max_weight;
+    bounds.weights.push_back({1.0, max_weight});
+    bounds.bisections.push_back(
+        {width / (2.0 * _hyperx.concentration),
+         width * max_weight / (2.0 * _hyperx.concentration)});
+  }
+
+  f64 low = bound(root_, bounds, 0).low;
+  return std::isnan(low) ? F64_NEG_INF : low;
+}
+
+u32 CostExpression::add(Op _op, u32 _left, u32 _right) {
+  bool leaf = (_op <= Op::kBisections);
+  bool unary = (_op == Op::kNegate) || (_op >= Op::kCeil);
+  bool reduction = (_op >= Op::kSum);
+  Node node = {_op, false, 0.0, _left, _right};
+  if (leaf) {
+    node.vector = (_op == Op::kWidths) || (_op == Op::kWeights) ||
+                  (_op == Op::kBisections);
+  } else if (!reduction) {
+    node.vector = nodes_.at(_left).vector ||
+                  (!unary && nodes_.at(_right).vector);
+  }
+
+  // fold operations on constants
+  bool constant =
+      !leaf && !reduction && (nodes_.at(_left).op == Op::kConstant) &&
+      (unary || (nodes_.at(_right).op == Op::kConstant));
+  nodes_.push_back(node);
+  u32 index = static_cast<u32>(nodes_.size() - 1);
+  if (constant) {
+    Network none = {};
+    f64 value = operand(index, none, nullptr, 0);
+    // the folded operands are the most recent nodes
+    nodes_.resize(std::min(_left, unary ? _left : _right));
+    nodes_.push_back({Op::kConstant, false, value, 0, 0});
+    index = static_cast<u32>(nodes_.size() - 1);
+  }
+  return index;
+}
+
+// leaves are evaluated inline, saving a call and a dispatch
+inline f64 CostExpression::operand(u32 _node, const Network& _network,
+                                   const Hyperx* _hyperx, u64 _dim) const {
+  const Node& node = nodes_[_node];
+  switch (node.op) {
+    case Op::kConstant:
+      return node.value;
+    case Op::kRouters:
+      return _network.routers;
+    case Op::kTerminals:
+      return _network.terminals;
+    case Op::kRouterRadix:
+      return _network.router_radix;
+    case Op::kChannels:
+      return _network.channels;
+    case Op::kDimensions:
+      return _hyperx->dimensions;
+    case Op::kConcentration:
+      return _hyperx->concentration;
+    case Op::kWidths:
+      return _hyperx->widths[_dim];
+    case Op::kWeights:
+      return _hyperx->weights[_dim];
+    case Op::kBisections:
+      return _network.bisections[_dim];
+    default:
+      return evaluate(_node, _network, _hyperx, _dim);
+  }
+}
+
+f64 CostExpression::evaluate(u32 _node, const Network& _network,
+                             const Hyperx* _hyperx, u64 _dim) const {
+  const Node& node = nodes_[_node];
+  switch (node.op) {
+    case Op::kAdd:
+      return operand(node.left, _network, _hyperx, _dim) +
+             operand(node.right, _network, _hyperx, _dim);
+    case Op::kSubtract:
+      return operand(node.left, _network, _hyperx, _dim) -
+             operand(node.right, _network, _hyperx, _dim);
+    case Op::kMultiply:
+      return operand(node.left, _network, _hyperx, _dim) *
+             operand(node.right, _network, _hyperx, _dim);
+    case Op::kDivide:
+      return operand(node.left, _network, _hyperx, _dim) /
+             operand(node.right, _network, _hyperx, _dim);
+    case Op::kPower:
+      return std::pow(operand(node.left, _network, _hyperx, _dim),
+                      operand(node.right, _network, _hyperx, _dim));
+    case Op::kNegate:
+      return -operand(node.left, _network, _hyperx, _dim);
+    case Op::kMin:
+      return std::min(operand(node.left, _network, _hyperx, _dim),
+                      operand(node.right, _network, _hyperx, _dim));
+    case Op::kMax:
+      return std::max(operand(node.left, _network, _hyperx, _dim),
+                      operand(node.right, _network, _hyperx, _dim));
+    case Op::kCeil:
+      return std::ceil(operand(node.left, _network, _hyperx, _dim));
+    case Op::kFloor:
+      return std::floor(operand(node.left, _network, _hyperx, _dim));
+    case Op::kSqrt:
+      return std::sqrt(operand(node.left, _network, _hyperx, _dim));
+    case Op::kLog2:
+      return std::log2(operand(node.left, _network, _hyperx, _dim));
+    case Op::kAbs:
+      return std::fabs(operand(node.left, _network, _hyperx, _dim));
+    case Op::kSum:
+    case Op::kProduct:
+    case Op::kMean:
+    case Op::kMinimum:
+    case Op::kMaximum:
+      break;
+    default:
+      return operand(_node, _network, _hyperx, _dim);
+  }
+
+  // reductions over the dimensions
+  u64 dims = (_hyperx != nullptr) ? _hyperx->dimensions :
+             _network.bisections.size();
+  f64 result = (node.op == Op::kProduct) ? 1.0 :
+               (node.op == Op::kMinimum) ? F64_POS_INF :
+               (node.op == Op::kMaximum) ? F64_NEG_INF : 0.0;
+  for (u64 dim = 0; dim < dims; dim++) {
+    f64 value = operand(node.left, _network, _hyperx, dim);
+    switch (node.op) {
+      case Op::kProduct:
+        result *= value;
+        break;
+      case Op::kMinimum:
+        result = std::min(result, value);
+        break;
+      case Op::kMaximum:
+        result = std::max(result, value);
+        break;
+      default:
+        result += value;
+        break;
+    }
+  }
+  return (node.op == Op::kMean) ? result / dims : result;
+}
+
+CostExpression::Interval CostExpression::bound(u32 _node,
+                                               const Bounds& _bounds,
+                                               u64 _dim) const {
+  const Node& node = nodes_[_node];
+  const Hyperx& hyperx = *_bounds.hyperx;
+  Interval a = {0.0, 0.0};
+  Interval b = {0.0, 0.0};
+  if ((node.op > Op::kBisections) && (node.op < Op::kSum)) {
+    a = bound(node.left, _bounds, _dim);
+    if ((node.op < Op::kNegate) || (node.op == Op::kMin) ||
+        (node.op == Op::kMax)) {
+      b = bound(node.right, _bounds, _dim);
+    }
+  }
+
+  switch (node.op) {
+    case Op::kConstant:
+      return {node.value, node.value};
+    case Op::kRouters:
+      return {static_cast<f64>(hyperx.routers),
+              static_cast<f64>(hyperx.routers)};
+    case Op::kTerminals:
+      return {static_cast<f64>(hyperx.terminals),
+              static_cast<f64>(hyperx.terminals)};
+    case Op::kRouterRadix:
+      return _bounds.router_radix;
+    case Op::kChannels:
+      return _bounds.channels;
+    case Op::kDimensions:
+      return {static_cast<f64>(hyperx.dimensions),
+              static_cast<f64>(hyperx.dimensions)};
+    case Op::kConcentration:
+      return {static_cast<f64>(hyperx.concentration),
+              static_cast<f64>(hyperx.concentration)};
+    case Op::kWidths:
+      return {static_cast<f64>(hyperx.widths[_dim]),
+              static_cast<f64>(hyperx.widths[_dim])};
+    case Op::kWeights:
+      return _bounds.weights[_dim];
+    case Op::kBisections:
+      return _bounds.bisections[_dim];
+    case Op::kAdd:
+      return {a.low + b.low, a.high + b.high};
+    case Op::kSubtract:
+      return {a.low - b.high, a.high - b.low};
+    case Op::kDivide:
+      if ((b.low <= 0.0) && (b.high >= 0.0)) {
+        return {F64_NEG_INF, F64_POS_INF};
+      }
+      b = {1.0 / b.high, 1.0 / b.low};
+      [[fallthrough]];
+    case Op::kMultiply: {
+      f64 products[] = {multiply(a.low, b.low), multiply(a.low, b.high),
+                        multiply(a.high, b.low), multiply(a.high, b.high)};
+      return {*std::min_element(products, products + 4),
+              *std::max_element(products, products + 4)};
+    }
+    case Op::kPower: {
+      // monotonic in each operand except across base 1 and exponent 0,
+      //  where the power is 1
+      if (a.low < 0.0) {
+        return {F64_NEG_INF, F64_POS_INF};
+      }
+      f64 powers[] = {std::pow(a.low, b.low), std::pow(a.low, b.high),
+                      std::pow(a.high, b.low), std::pow(a.high, b.high), 1.0};
+      u64 count = (((a.low <= 1.0) && (a.high >= 1.0)) ||
+                   ((b.low <= 0.0) && (b.high >= 0.0))) ? 5 : 4;
+      return {*std::min_element(powers, powers + count),
+              *std::max_element(powers, powers + count)};
+    }
+    case Op::kNegate:
+      return {-a.high, -a.low};
+    case Op::kMin:
+      return {std::min(a.low, b.low), std::min(a.high, b.high)};
+    case Op::kMax:
+      return {std::max(a.low, b.low), std::max(a.high, b.high)};
+    case Op::kCeil:
+      return {std::ceil(a.low), std::ceil(a.high)};
+    case Op::kFloor:
+      return {std::floor(a.low), std::floor(a.high)};
+    case Op::kSqrt:
+      return {(a.low <= 0.0) ? 0.0 : std::sqrt(a.low), std::sqrt(a.high)};
+    case Op::kLog2:
+      return {(a.low <= 0.0) ? F64_NEG_INF : std::log2(a.low),
+              std::log2(a.high)};
+    case Op::kAbs:
+      if ((a.low <= 0.0) && (a.high >= 0.0)) {
+        return {0.0, std::max(-a.low, a.high)};
+      }
+      return {std::min(std::fabs(a.low), std::fabs(a.high)),
+              std::max(std::fabs(a.low), std::fabs(a.high))};
+    default:
+      break;
+  }
+
+  // reductions over the dimensions
+  Interval result = (node.op == Op::kProduct) ? Interval{1.0, 1.0} :
+                    (node.op == Op::kMinimum) ?
+                    Interval{F64_POS_INF, F64_POS_INF} :
+                    (node.op == Op::kMaximum) ?
+                    Interval{F64_NEG_INF, F64_NEG_INF} : Interval{0.0, 0.0};
+  for (u64 dim = 0; dim < hyperx.dimensions; dim++) {
+    Interval value = bound(node.left, _bounds, dim);
+    switch (node.op) {
+      case Op::kProduct: {
+        f64 products[] = {multiply(result.low, value.low),
+                          multiply(result.low, value.high),
+                          multiply(result.high, value.low),
+                          multiply(result.high, value.high)};
+        result = {*std::min_element(products, products + 4),
+                  *std::max_element(products, products + 4)};
+        break;
+      }
+      case Op::kMinimum:
+        result = {std::min(result.low, value.low),
+                  std::min(result.high, value.high)};
+        break;
+      case Op::kMaximum:
+        result = {std::max(result.low, value.low),
+                  std::max(result.high, value.high)};
+        break;
+      default:
+        result = {result.low + value.low, result.high + value.high};
+        break;
+    }
+  }
+  if (node.op == Op::kMean) {
+    result = {result.low / hyperx.dimensions, result.high / hyperx.dimensions};
+  }
+  return result;
+}
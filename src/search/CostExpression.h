@@ -0,0 +1,135 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_COSTEXPRESSION_H_
+#define SEARCH_COSTEXPRESSION_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Calculator.h"
+#include "search/Engine.h"
+
+// Costs networks with an arithmetic expression given at runtime, e.g.,
+//  "routers * ROUTER_PRICE + sum(widths * weights) * CABLE_PRICE"
+//
+// Names are the fields of Hyperx: routers, terminals, router_radix, channels,
+//  dimensions, and concentration are scalars; widths, weights, and bisections
+//  hold a value per dimension. Per dimension values combine element-wise and
+//  must be reduced to a scalar with sum(), prod(), mean(), or the single
+//  argument forms of min() and max(). Other names are constants given to the
+//  constructor. The operators are + - * / ^ and the functions are min(a, b),
+//  max(a, b), ceil(), floor(), sqrt(), log2(), and abs().
+//
+// The expression is parsed once into a flat tree with constant subtrees
+//  folded, so evaluation never allocates. Interval arithmetic over the
+//  possible weights gives lowerBound() for pruning.
+class CostExpression : public Calculator {
+ public:
+  CostExpression(const std::string& _expression,
+                 const std::unordered_map<std::string, f64>& _constants);
+  ~CostExpression();
+
+  f64 cost(const Hyperx& _hyperx) const override;
+  f64 networkCost(const Network& _network) const override;
+  f64 lowerBound(const Hyperx& _hyperx,
+                 const std::vector<u64>& _max_weights) const override;
+
+ private:
+  enum class Op : u8 {
+    kConstant,
+    kRouters,
+    kTerminals,
+    kRouterRadix,
+    kChannels,
+    kDimensions,
+    kConcentration,
+    kWidths,
+    kWeights,
+    kBisections,
+    kAdd,
+    kSubtract,
+    kMultiply,
+    kDivide,
+    kPower,
+    kNegate,
+    kMin,
+    kMax,
+    kCeil,
+    kFloor,
+    kSqrt,
+    kLog2,
+    kAbs,
+    kSum,
+    kProduct,
+    kMean,
+    kMinimum,
+    kMaximum
+  };
+
+  struct Node {
+    Op op;
+    bool vector;  // has a value per dimension
+    f64 value;    // kConstant only
+    u32 left;
+    u32 right;
+  };
+
+  struct Interval {
+    f64 low;
+    f64 high;
+  };
+
+  // the ranges of the fields while the weights are unknown
+  struct Bounds {
+    const Hyperx* hyperx;
+    Interval router_radix;
+    Interval channels;
+    std::vector<Interval> weights;
+    std::vector<Interval> bisections;
+  };
+
+  class Parser;
+
+  u32 add(Op _op, u32 _left, u32 _right);
+  f64 evaluate(u32 _node, const Network& _network, const Hyperx* _hyperx,
+               u64 _dim) const;
+  f64 operand(u32 _node, const Network& _network, const Hyperx* _hyperx,
+              u64 _dim) const;
+  Interval bound(u32 _node, const Bounds& _bounds, u64 _dim) const;
+
+  std::vector<Node> nodes_;
+  u32 root_;
+  bool hyperx_only_;  // uses fields that only HyperX networks have
+};
+
+#endif  // SEARCH_COSTEXPRESSION_H_
@@ -0,0 +1,244 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/CostExpression.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+
+namespace {
+
+// a configuration with all derived fields computed
+Hyperx configure(const std::vector<u64>& _widths,
+                 const std::vector<u64>& _weights, u64 _concentration) {
+  Hyperx hyperx;
+  hyperx.dimensions = _widths.size();
+  hyperx.widths = _widths;
+  hyperx.weights = _weights;
+  hyperx.concentration = _concentration;
+  hyperx.routers = 1;
+  hyperx.router_radix = _concentration;
+  for (u64 dim = 0; dim < hyperx.dimensions; dim++) {
+    hyperx.routers *= _widths.at(dim);
+    hyperx.router_radix += (_widths.at(dim) - 1) * _weights.at(dim);
+    hyperx.bisections.push_back((_widths.at(dim) * _weights.at(dim)) /
+                                (2.0 * _concentration));
+  }
+  hyperx.terminals = hyperx.routers * _concentration;
+  hyperx.channels = Engine::channelCount(hyperx);
+  hyperx.cost = 0.0;
+  return hyperx;
+}
+
+f64 cost(const std::string& _expression, const Hyperx& _hyperx,
+         const std::unordered_map<std::string, f64>& _constants = {}) {
+  return CostExpression(_expression, _constants).cost(_hyperx);
+}
+
+// the message of the error parsing the expression
+std::string error(const std::string& _expression) {
+  try {
+    CostExpression expression(_expression, {{"PRICE", 2.0}});
+  } catch (std::runtime_error& e) {
+    return e.what();
+  }
+  return "";
+}
+
+}  // namespace
+
+TEST(CostExpression, precedence) {
+  Hyperx hyperx = configure({4}, {1}, 2);  // 4 routers
+  EXPECT_EQ(cost("2 + 3 * routers", hyperx), 14.0);
+  EXPECT_EQ(cost("(2 + 3) * routers", hyperx), 20.0);
+  EXPECT_EQ(cost("routers * 3 + 2", hyperx), 14.0);
+  EXPECT_EQ(cost("routers + 12 / routers", hyperx), 7.0);
+  EXPECT_EQ(cost("2 * routers ^ 2", hyperx), 32.0);
+  EXPECT_EQ(cost("-routers ^ 2", hyperx), -16.0);
+  EXPECT_EQ(cost("routers ^ -1", hyperx), 0.25);
+  EXPECT_EQ(cost("routers * -2", hyperx), -8.0);
+  EXPECT_EQ(cost("- -routers", hyperx), 4.0);
+}
+
+TEST(CostExpression, associativity) {
+  Hyperx hyperx = configure({4}, {1}, 2);  // 4 routers
+  EXPECT_EQ(cost("routers - 2 - 1", hyperx), 1.0);
+  EXPECT_EQ(cost("routers / 2 / 2", hyperx), 1.0);
+  EXPECT_EQ(cost("routers - 2 + 1", hyperx), 3.0);
+  EXPECT_EQ(cost("routers / 2 * 4", hyperx), 8.0);
+  EXPECT_EQ(cost("2 ^ 3 ^ 2 + routers", hyperx), 516.0);
+  EXPECT_EQ(cost("routers ^ 2 ^ 0.5", hyperx),
+            std::pow(4.0, std::pow(2.0, 0.5)));
+}
+
+TEST(CostExpression, fields) {
+  Hyperx hyperx = configure({3, 5}, {2, 1}, 4);
+  EXPECT_EQ(cost("routers", hyperx), 15.0);
+  EXPECT_EQ(cost("terminals", hyperx), 60.0);
+  EXPECT_EQ(cost("router_radix", hyperx), 12.0);
+  EXPECT_EQ(cost("channels", hyperx), static_cast<f64>(hyperx.channels));
+  EXPECT_EQ(cost("dimensions", hyperx), 2.0);
+  EXPECT_EQ(cost("concentration", hyperx), 4.0);
+  EXPECT_EQ(cost("sum(widths)", hyperx), 8.0);
+  EXPECT_EQ(cost("prod(widths * weights)", hyperx), 30.0);
+  EXPECT_EQ(cost("mean(weights)", hyperx), 1.5);
+  EXPECT_EQ(cost("min(bisections)", hyperx), 0.625);
+  EXPECT_EQ(cost("max(bisections)", hyperx), 0.75);
+  EXPECT_EQ(cost("sum(widths - 1) + concentration", hyperx), 10.0);
+  EXPECT_EQ(cost("PRICE * routers", hyperx, {{"PRICE", 2.5}}), 37.5);
+  EXPECT_EQ(cost("min(routers, 7) + max(routers, 7)", hyperx), 22.0);
+  EXPECT_EQ(cost("ceil(routers / 2) + floor(routers / 2)", hyperx), 15.0);
+  EXPECT_EQ(cost("sqrt(routers + 1) + log2(routers + 1)", hyperx), 8.0);
+  EXPECT_EQ(cost("abs(5 - routers)", hyperx), 10.0);
+}
+
+TEST(CostExpression, folding) {
+  // constant subtrees in every position fold to the same values
+  Hyperx hyperx = configure({4}, {1}, 2);  // 4 routers
+  EXPECT_EQ(cost("(1 + 2) * (3 + 4) * routers", hyperx), 84.0);
+  EXPECT_EQ(cost("routers * (1 + 2) * (3 + 4)", hyperx), 84.0);
+  EXPECT_EQ(cost("routers + 2 * 3 - 8 / 4", hyperx), 8.0);
+  EXPECT_EQ(cost("2 * 3 + routers * (8 / 4)", hyperx), 14.0);
+  EXPECT_EQ(cost("min(2, 3) + max(4, 1) * routers", hyperx), 18.0);
+  EXPECT_EQ(cost("-(-(2)) * routers - -1", hyperx), 9.0);
+  EXPECT_EQ(cost("sqrt(16) ^ 0.5 * routers + abs(-3)", hyperx), 11.0);
+  EXPECT_EQ(cost("routers * (2 ^ 3 ^ 2) / (2 ^ 9)", hyperx), 4.0);
+  EXPECT_EQ(cost("sum(widths * (1 + 1)) + (2 + 3)", hyperx), 13.0);
+  EXPECT_EQ(cost("((((1 + 1) + 1) + 1) + routers) * (1 - 2)", hyperx),
+            -8.0);
+  EXPECT_EQ(cost("PRICE * PRICE + routers", hyperx, {{"PRICE", 3.0}}),
+            13.0);
+  EXPECT_EQ(cost("1 + 2 * 3", hyperx), 7.0);
+}
+
+TEST(CostExpression, errors) {
+  EXPECT_EQ(error("routers +"),
+            "cost expression: unexpected end at position 9");
+  EXPECT_EQ(error("routers $ 2"),
+            "cost expression: unexpected '$' at position 8");
+  EXPECT_EQ(error("routers * foo"),
+            "cost expression: unknown name foo at position 13");
+  EXPECT_EQ(error("foo(routers)"),
+            "cost expression: unknown function foo() at position 4");
+  EXPECT_EQ(error("(routers + 1"),
+            "cost expression: expected ')' at position 12");
+  EXPECT_EQ(error("sum(routers)"),
+            "cost expression: sum() needs per dimension values at position "
+            "12");
+  EXPECT_EQ(error("min(routers, 1, 2)"),
+            "cost expression: wrong number of arguments to min() at position "
+            "18");
+  EXPECT_EQ(error("routers + widths"),
+            "cost expression: per dimension values must be reduced to a "
+            "scalar at position 16");
+  EXPECT_EQ(error("PRICE * routers"), "");
+}
+
+TEST(CostExpression, networkCost) {
+  Hyperx hyperx = configure({3, 5}, {2, 1}, 4);
+  const Network& network = hyperx;
+  EXPECT_EQ(CostExpression("routers + sum(bisections)", {})
+                .networkCost(network),
+            15.0 + 0.75 + 0.625);
+  EXPECT_THROW(CostExpression("sum(widths)", {}).networkCost(network),
+               std::runtime_error);
+}
+
+TEST(CostExpression, lowerBound) {
+  // the bound never exceeds the cost of any weights within the maximums
+  const std::vector<std::string> expressions = {
+      "routers * 100 + channels",
+      "sum(widths * weights) * routers",
+      "router_radix ^ 2 - channels / 10",
+      "routers * 100 / min(bisections)",
+      "max(bisections) - min(bisections)",
+      "prod(weights) + mean(bisections) * -5",
+      "routers * ceil(router_radix / 16) + floor(sqrt(channels))",
+      "abs(router_radix - 20) + log2(channels)",
+      "min(router_radix, 18) * max(channels, 500)",
+      "sum(1 / weights) + prod(bisections - 1)",
+      "-max(weights) + 2 ^ (router_radix / 8) - 0.5 ^ min(weights)",
+      "(router_radix - 15) * (channels - 400) / (router_radix + 1)",
+      "terminals / (sum(weights) - 3)"};
+  const std::vector<std::vector<u64>> widths = {
+      {8}, {2, 5}, {3, 3}, {4, 6}, {2, 3, 4}, {3, 3, 3}};
+  for (const std::string& text : expressions) {
+    CostExpression expression(text, {});
+    for (const std::vector<u64>& width : widths) {
+      for (u64 concentration = 1; concentration <= 6; concentration++) {
+        for (u64 limit = 1; limit <= 4; limit++) {
+          std::vector<u64> max_weights(width.size(), limit);
+          max_weights.at(0) = limit + 1;
+          Hyperx hyperx = configure(width, std::vector<u64>(width.size(), 1),
+                                    concentration);
+          f64 bound = expression.lowerBound(hyperx, max_weights);
+
+          // enumerate every weight vector within the maximums
+          std::vector<u64> weights(width.size(), 1);
+          while (true) {
+            Hyperx weighted = configure(width, weights, concentration);
+            f64 value = expression.cost(weighted);
+            if (!std::isnan(value)) {
+              EXPECT_LE(bound, value + 1e-9 * std::fabs(value))
+                  << text << " S=" << weighted.dimensions
+                  << " T=" << concentration << " K0=" << weights.at(0);
+            }
+            u64 dim;
+            for (dim = 0; dim < weights.size(); dim++) {
+              if (weights.at(dim) < max_weights.at(dim)) {
+                weights.at(dim)++;
+                break;
+              }
+              weights.at(dim) = 1;
+            }
+            if (dim == weights.size()) {
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(CostExpression, lowerBoundTight) {
+  // expressions increasing in the weights are bounded by unit weights
+  CostExpression expression("routers * 100 + channels", {});
+  Hyperx hyperx = configure({4, 6}, {1, 1}, 3);
+  EXPECT_EQ(expression.lowerBound(hyperx, {5, 5}), expression.cost(hyperx));
+}
@@ -0,0 +1,137 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Cursor.h"
+
+#include <algorithm>
+
+Cursor::Cursor(Engine* _engine)
+    : engine_(_engine), region_(0), base_radix_(0), in_region_(false),
+      in_concentration_(false), too_big_radix_(false), ldim_(0) {
+  // stage1() gathers the width configurations in search order
+  engine_->hyperx_ = Hyperx();
+  engine_->coverage_ = Coverage();
+  engine_->exhausted_ = false;
+  engine_->collect();
+  regions_.swap(engine_->regions_);
+  region_widths_.swap(engine_->region_widths_);
+}
+
+Cursor::~Cursor() {}
+
+bool Cursor::next() {
+  while (true) {
+    if (!in_concentration_) {
+      if (!nextConcentration()) {
+        return false;
+      }
+    } else if (!nextWeights()) {
+      in_concentration_ = false;
+      continue;
+    }
+    if (feasible()) {
+      return true;
+    }
+  }
+}
+
+const Hyperx& Cursor::current() const {
+  return hyperx_;
+}
+
+f64 Cursor::cost() {
+  hyperx_.cost = engine_->cost_function_->cost(hyperx_);
+  return hyperx_.cost;
+}
+
+void Cursor::skipWidths() {
+  in_region_ = false;
+  in_concentration_ = false;
+}
+
+void Cursor::skipConcentration() {
+  in_concentration_ = false;
+}
+
+bool Cursor::nextConcentration() {
+  // stage2(), moving to the next region when one is done
+  while (true) {
+    if (!in_region_) {
+      if (region_ == regions_.size()) {
+        return false;
+      }
+      const Engine::Region& region = regions_.at(region_++);
+      hyperx_.dimensions = region.dimensions;
+      hyperx_.widths.assign(region_widths_.begin() + region.offset,
+                            region_widths_.begin() + region.offset +
+                                region.dimensions);
+      hyperx_.routers = region.routers;
+      base_radix_ = 0;
+      for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
+        base_radix_ += hyperx_.widths.at(dim) - 1;
+      }
+      hyperx_.concentration = engine_->firstConcentration(hyperx_);
+      in_region_ = true;
+    } else {
+      hyperx_.concentration++;
+    }
+
+    if (hyperx_.concentration > engine_->max_concentration_) {
+      in_region_ = false;
+      continue;
+    }
+    TraceReason reason;
+    in_region_ = engine_->checkConcentration(&hyperx_, base_radix_, &reason);
+    if (reason == TraceReason::kAccept) {
+      // the start of stage3()
+      engine_->weightLimits(hyperx_, &max_weights_);
+      hyperx_.weights.assign(hyperx_.dimensions, 1);
+      too_big_radix_ = false;
+      ldim_ = 0;
+      in_concentration_ = true;
+      return true;
+    }
+  }
+}
+
+bool Cursor::nextWeights() {
+  return engine_->nextWeights(max_weights_, too_big_radix_, &hyperx_, &ldim_);
+}
+
+bool Cursor::feasible() {
+  TraceReason reason = engine_->checkWeights<true>(&hyperx_);
+  too_big_radix_ = (reason == TraceReason::kRadixHigh);
+  if (reason != TraceReason::kAccept) {
+    return false;
+  }
+  hyperx_.channels = Engine::channelCount(hyperx_);
+  hyperx_.cost = 0.0;
+  return true;
+}
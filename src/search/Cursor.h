@@ -0,0 +1,89 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_CURSOR_H_
+#define SEARCH_CURSOR_H_
+
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+
+// a resumable walk over the search space of an engine that yields its
+//  feasible configurations (those reaching stage4() of a search) one at a
+//  time, in search order, without costing or keeping them. the caller pulls
+//  configurations with next() and can abandon the rest of the current widths
+//  or concentration as soon as they stop being interesting.
+//
+// the width configurations are gathered when the cursor is created, as in a
+//  budgeted search, the concentrations and weights are walked lazily. the
+//  engine must not run while a cursor walks its space.
+class Cursor {
+ public:
+  explicit Cursor(Engine* _engine);
+  ~Cursor();
+
+  // moves to the next feasible configuration, false when none remain
+  bool next();
+
+  // the current configuration with all fields except the cost computed. it is
+  //  only valid until the cursor moves.
+  const Hyperx& current() const;
+
+  // costs the current configuration with the engine's cost function, which
+  //  also sets the cost of current()
+  f64 cost();
+
+  // skips the remaining configurations with the current widths, or with the
+  //  current widths and concentration. next() moves past them.
+  void skipWidths();
+  void skipConcentration();
+
+ private:
+  Engine* engine_;
+  std::vector<Engine::Region> regions_;
+  std::vector<u64> region_widths_;
+  u64 region_;  // the next region to load
+
+  // the odometer state of stage2() and stage3()
+  Hyperx hyperx_;
+  u64 base_radix_;  // without terminals
+  std::vector<u64> max_weights_;
+  bool in_region_;
+  bool in_concentration_;
+  bool too_big_radix_;  // the last weights exceeded the radix
+  u64 ldim_;            // last incremented dimension
+
+  bool nextConcentration();
+  bool nextWeights();
+  bool feasible();
+};
+
+#endif  // SEARCH_CURSOR_H_
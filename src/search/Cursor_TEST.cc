@@ -0,0 +1,131 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Cursor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/RouterChannelCount.h"
+
+namespace {
+
+typedef std::tuple<std::vector<u64>, std::vector<u64>, u64> Key;
+
+Key key(const Hyperx& _hyperx) {
+  return Key(_hyperx.widths, _hyperx.weights, _hyperx.concentration);
+}
+
+void checkCursor(bool _fixed_width, bool _fixed_weight) {
+  RouterChannelCount calc;
+  Engine engine(1, 4, 2, 24, 1, 24, 200, 500, 0.3, 2.0, 24, 24, _fixed_width,
+                _fixed_weight, 100000, &calc);
+
+  // every feasible configuration is a result
+  engine.run();
+  std::vector<Key> expected;
+  for (const Hyperx& res : engine.results()) {
+    expected.push_back(key(res));
+  }
+  std::sort(expected.begin(), expected.end());
+  ASSERT_LT(expected.size(), 100000u);
+  ASSERT_GT(expected.size(), 0u);
+
+  engine.count();
+  u64 feasible = 0;
+  for (const SpaceCount& count : engine.counts()) {
+    feasible += count.feasible;
+  }
+
+  Cursor cursor(&engine);
+  std::vector<Key> yielded;
+  while (cursor.next()) {
+    const Hyperx& current = cursor.current();
+    EXPECT_EQ(current.terminals, current.routers * current.concentration);
+    EXPECT_EQ(current.channels, Engine::channelCount(current));
+    EXPECT_EQ(cursor.cost(), calc.cost(current));
+    yielded.push_back(key(current));
+  }
+  EXPECT_EQ(yielded.size(), feasible);
+  std::sort(yielded.begin(), yielded.end());
+  EXPECT_EQ(yielded, expected);
+}
+
+}  // namespace
+
+TEST(Cursor, yieldsResults) {
+  checkCursor(false, false);
+}
+
+TEST(Cursor, yieldsResultsFixedWidth) {
+  checkCursor(true, false);
+}
+
+TEST(Cursor, yieldsResultsFixedWeight) {
+  checkCursor(false, true);
+}
+
+TEST(Cursor, skips) {
+  RouterChannelCount calc;
+  Engine engine(1, 4, 2, 24, 1, 24, 200, 500, 0.3, 2.0, 24, 24, false, false,
+                10, &calc);
+
+  // skipping the widths of a configuration leaves no more with its widths
+  Cursor widths(&engine);
+  u64 yielded = 0;
+  std::vector<std::vector<u64>> seen;
+  while (widths.next()) {
+    yielded++;
+    const Hyperx& current = widths.current();
+    EXPECT_EQ(std::find(seen.begin(), seen.end(), current.widths),
+              seen.end());
+    seen.push_back(current.widths);
+    widths.skipWidths();
+  }
+  EXPECT_GT(yielded, 0u);
+
+  // skipping the concentration leaves no more with the same concentration
+  Cursor concentrations(&engine);
+  std::vector<std::pair<std::vector<u64>, u64>> pairs;
+  while (concentrations.next()) {
+    const Hyperx& current = concentrations.current();
+    std::pair<std::vector<u64>, u64> pair(current.widths,
+                                          current.concentration);
+    EXPECT_EQ(std::find(pairs.begin(), pairs.end(), pair), pairs.end());
+    pairs.push_back(pair);
+    concentrations.skipConcentration();
+  }
+  EXPECT_GE(pairs.size(), yielded);
+}
@@ -0,0 +1,168 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Dragonfly.h"
+
+#include <algorithm>
+#include <cmath>
+
+static u64 tri(u64 _width) {
+  return (_width * (_width - 1)) / 2;
+}
+
+// global channels are spread evenly across the routers of a group
+static u64 globalPorts(const Dragonfly& _dragonfly) {
+  u64 channels = (_dragonfly.global_width - 1) * _dragonfly.global_weight;
+  return (channels + _dragonfly.local_width - 1) / _dragonfly.local_width;
+}
+
+DragonflyEngine::DragonflyEngine(const Engine* _limits)
+    : FamilyEngine<Dragonfly>(_limits) {}
+
+DragonflyEngine::~DragonflyEngine() {}
+
+std::string DragonflyEngine::family() const {
+  return "dragonfly";
+}
+
+void DragonflyEngine::run() {
+  results_.clear();
+  dragonfly_ = Dragonfly();
+  dragonfly_.bisections.resize(2);
+
+  u64 min_concentration = std::max<u64>(1, limits_->minConcentration());
+  u64 max_radix = limits_->maxRadix();
+  u64 max_width = limits_->maxWidth();
+
+  /*
+   * loop over the routers per group
+   */
+  for (dragonfly_.local_width = 2; dragonfly_.local_width <= max_width;
+       dragonfly_.local_width++) {
+    // every router has at least one local port per router in the group
+    if (min_concentration + dragonfly_.local_width > max_radix) {
+      break;
+    }
+
+    /*
+     * loop over the number of groups
+     */
+    for (dragonfly_.global_width = 2; dragonfly_.global_width <= max_width;
+         dragonfly_.global_width++) {
+      dragonfly_.routers = dragonfly_.local_width * dragonfly_.global_width;
+      if (dragonfly_.routers > limits_->maxTerminals()) {
+        break;
+      }
+      dragonfly_.local_weight = 1;
+      dragonfly_.global_weight = 1;
+      u64 base_radix = (dragonfly_.local_width - 1) + globalPorts(dragonfly_);
+      if (base_radix + min_concentration > max_radix) {
+        // more groups only need more global ports
+        break;
+      }
+
+      /*
+       * loop over concentration, starting at the first one that reaches the
+       *  minimum number of terminals
+       */
+      u64 first_concentration = std::max(
+          min_concentration,
+          (limits_->minTerminals() + dragonfly_.routers - 1) /
+              dragonfly_.routers);
+      for (dragonfly_.concentration = first_concentration;
+           dragonfly_.concentration <= limits_->maxConcentration();
+           dragonfly_.concentration++) {
+        dragonfly_.terminals = dragonfly_.routers * dragonfly_.concentration;
+        if ((dragonfly_.terminals > limits_->maxTerminals()) ||
+            (base_radix + dragonfly_.concentration > max_radix)) {
+          break;
+        }
+        weights();
+      }
+    }
+  }
+}
+
+std::string DragonflyEngine::parameters(u64 _index) const {
+  const Dragonfly& dragonfly = results_.at(_index);
+  return "global=" + std::to_string(dragonfly.global_width) + "x" +
+         std::to_string(dragonfly.global_weight) +
+         " local=" + std::to_string(dragonfly.local_width) + "x" +
+         std::to_string(dragonfly.local_weight) +
+         " T=" + std::to_string(dragonfly.concentration);
+}
+
+void DragonflyEngine::weights() {
+  // start at or below the smallest weights meeting the minimum bandwidth,
+  //  the limit checks reject the ones below it
+  f64 terminals_2x = 2.0 * dragonfly_.concentration;
+  u64 first_local = std::max<u64>(
+      1, static_cast<u64>(std::floor(limits_->minBandwidth() * terminals_2x /
+                                     dragonfly_.local_width)));
+  u64 first_global = std::max<u64>(
+      1, static_cast<u64>(std::floor(
+             limits_->minBandwidth() * terminals_2x * dragonfly_.local_width /
+             dragonfly_.global_width)));
+
+  for (dragonfly_.local_weight = first_local;
+       dragonfly_.local_weight <= limits_->maxWeight();
+       dragonfly_.local_weight++) {
+    dragonfly_.bisections.at(1) =
+        (dragonfly_.local_width * dragonfly_.local_weight) / terminals_2x;
+    dragonfly_.global_weight = first_global;
+    u64 local_radix = dragonfly_.concentration +
+                      (dragonfly_.local_width - 1) * dragonfly_.local_weight;
+    if ((local_radix + globalPorts(dragonfly_) > limits_->maxRadix()) ||
+        (dragonfly_.bisections.at(1) > limits_->maxBandwidth())) {
+      break;
+    }
+
+    for (dragonfly_.global_weight = first_global;
+         dragonfly_.global_weight <= limits_->maxWeight();
+         dragonfly_.global_weight++) {
+      dragonfly_.router_radix = local_radix + globalPorts(dragonfly_);
+      dragonfly_.bisections.at(0) =
+          (dragonfly_.global_width * dragonfly_.global_weight) /
+          (terminals_2x * dragonfly_.local_width);
+      if ((dragonfly_.router_radix > limits_->maxRadix()) ||
+          (dragonfly_.bisections.at(0) > limits_->maxBandwidth())) {
+        break;
+      }
+      if (withinLimits(dragonfly_)) {
+        dragonfly_.channels =
+            dragonfly_.terminals +
+            dragonfly_.global_width * tri(dragonfly_.local_width) *
+                dragonfly_.local_weight +
+            tri(dragonfly_.global_width) * dragonfly_.global_weight;
+        consider(&dragonfly_);
+      }
+    }
+  }
+}
@@ -0,0 +1,65 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_DRAGONFLY_H_
+#define SEARCH_DRAGONFLY_H_
+
+#include <string>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/FamilyEngine.h"
+#include "search/Network.h"
+
+// bisections are {global, local}
+struct Dragonfly : public Network {
+  u64 global_width;   // groups
+  u64 global_weight;  // channels between each pair of groups
+  u64 local_width;    // routers per group
+  u64 local_weight;   // channels between each pair of routers in a group
+  u64 concentration;  // terminals per router
+};
+
+class DragonflyEngine : public FamilyEngine<Dragonfly> {
+ public:
+  explicit DragonflyEngine(const Engine* _limits);
+  ~DragonflyEngine();
+
+  std::string family() const override;
+  void run() override;
+  std::string parameters(u64 _index) const override;
+
+ private:
+  void weights();
+
+  Dragonfly dragonfly_;
+};
+
+#endif  // SEARCH_DRAGONFLY_H_
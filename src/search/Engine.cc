@@ -32,16 +32,32 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <stdexcept>
 
 #include "strop/strop.h"
 
-static const u8 HSE_DEBUG = 0;
-
 CostFunction::CostFunction() {}
 CostFunction::~CostFunction() {}
 
-bool Comparator::operator()(const Hyperx& _lhs, const Hyperx& _rhs) const {
+f64 CostFunction::networkCost(const Network& /*_network*/) const {
+  throw std::runtime_error("the cost function only supports HyperX");
+}
+
+f64 CostFunction::lowerBound(const Hyperx& /*_hyperx*/,
+                             const std::vector<u64>& /*_max_weights*/) const {
+  return F64_NEG_INF;
+}
+
+u64 CostFunction::classes() const {
+  return 0;
+}
+
+u64 CostFunction::classify(const Hyperx& /*_hyperx*/) const {
+  return U64_MAX;
+}
+
+bool Comparator::operator()(const Network& _lhs, const Network& _rhs) const {
   return _rhs.cost > _lhs.cost;
 }
 
@@ -66,7 +82,21 @@ Engine::Engine(u64 _min_dimensions, u64 _max_dimensions, u64 _min_radix,
       fixed_width_(_fixed_width),
       fixed_weight_(_fixed_weight),
       max_results_(_max_results),
-      cost_function_(_cost_function) {
+      cost_function_(_cost_function),
+      classes_(0),
+      bandwidth_curve_(false),
+      spill_(nullptr),
+      time_limit_(F64_POS_INF),
+      node_limit_(U64_MAX),
+      collect_(false),
+      exhausted_(false),
+      slice_end_(U64_MAX),
+      sliced_(false),
+      resume_concentration_(0),
+      resume_ldim_(0),
+      counting_(false),
+      tracer_(nullptr),
+      stage3_(&Engine::stage3<CostFunction>) {
   if (min_dimensions_ < 1) {
     throw std::runtime_error("mindimensions must be greater than 0");
   } else if (max_dimensions_ < min_dimensions_) {
@@ -106,17 +136,430 @@ Engine::Engine(u64 _min_dimensions, u64 _max_dimensions, u64 _min_radix,
 
 Engine::~Engine() {}
 
+std::string Engine::family() const {
+  return "hyperx";
+}
+
+void Engine::setTracer(Tracer* _tracer) {
+  tracer_ = _tracer;
+}
+
+void Engine::setBandwidthCurve(bool _enabled) {
+  bandwidth_curve_ = _enabled;
+}
+
+void Engine::setResultSpill(ResultSpill* _spill) {
+  spill_ = _spill;
+}
+
+u64 Engine::minDimensions() const {
+  return min_dimensions_;
+}
+
+u64 Engine::maxDimensions() const {
+  return max_dimensions_;
+}
+
+u64 Engine::minRadix() const {
+  return min_radix_;
+}
+
+u64 Engine::maxRadix() const {
+  return max_radix_;
+}
+
+u64 Engine::minConcentration() const {
+  return min_concentration_;
+}
+
+u64 Engine::maxConcentration() const {
+  return max_concentration_;
+}
+
+u64 Engine::minTerminals() const {
+  return min_terminals_;
+}
+
+u64 Engine::maxTerminals() const {
+  return max_terminals_;
+}
+
+f64 Engine::minBandwidth() const {
+  return min_bandwidth_;
+}
+
+f64 Engine::maxBandwidth() const {
+  return max_bandwidth_;
+}
+
+u64 Engine::maxWidth() const {
+  return max_width_;
+}
+
+u64 Engine::maxWeight() const {
+  return max_weight_;
+}
+
+bool Engine::fixedWidth() const {
+  return fixed_width_;
+}
+
+bool Engine::fixedWeight() const {
+  return fixed_weight_;
+}
+
+u64 Engine::maxResults() const {
+  return max_results_;
+}
+
+const CostFunction* Engine::costFunction() const {
+  return cost_function_;
+}
+
+u64 Engine::channelCount(const Hyperx& _hyperx) {
+  u64 channels = _hyperx.terminals;
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    u64 triNum = _hyperx.widths.at(dim);
+    triNum = (triNum * (triNum - 1)) / 2;
+    u64 dim_channels = _hyperx.weights.at(dim) * triNum;
+    for (u64 dim2 = 0; dim2 < _hyperx.dimensions; dim2++) {
+      if (dim2 != dim) {
+        dim_channels *= _hyperx.widths.at(dim2);
+      }
+    }
+    channels += dim_channels;
+  }
+  return channels;
+}
+
+bool Engine::evaluate(Hyperx* _hyperx) const {
+  if ((_hyperx->widths.size() != _hyperx->dimensions) ||
+      (_hyperx->weights.size() != _hyperx->dimensions)) {
+    throw std::runtime_error("widths and weights must match dimensions");
+  }
+
+  // compute the derived fields
+  _hyperx->routers = 1;
+  _hyperx->router_radix = _hyperx->concentration;
+  _hyperx->bisections.resize(_hyperx->dimensions);
+  bool ok = true;
+  for (u64 dim = 0; dim < _hyperx->dimensions; dim++) {
+    u64 width = _hyperx->widths.at(dim);
+    u64 weight = _hyperx->weights.at(dim);
+    ok &= (width >= 2) && (width <= max_width_) && (weight >= 1) &&
+          (weight <= max_weight_);
+    ok &= !fixed_width_ || (width == _hyperx->widths.at(0));
+    ok &= !fixed_weight_ || (weight == _hyperx->weights.at(0));
+    if (__builtin_mul_overflow(_hyperx->routers, width, &_hyperx->routers)) {
+      _hyperx->routers = U64_MAX;
+    }
+    _hyperx->router_radix += (width - 1) * weight;
+    _hyperx->bisections.at(dim) =
+        (width * weight) / (2.0 * _hyperx->concentration);
+    ok &= (_hyperx->bisections.at(dim) >= min_bandwidth_) &&
+          (_hyperx->bisections.at(dim) <= max_bandwidth_);
+  }
+  if (__builtin_mul_overflow(_hyperx->routers, _hyperx->concentration,
+                             &_hyperx->terminals)) {
+    _hyperx->terminals = U64_MAX;
+  }
+
+  // check the remaining limits
+  ok &= (_hyperx->dimensions >= min_dimensions_) &&
+        (_hyperx->dimensions <= max_dimensions_) &&
+        (_hyperx->concentration >= min_concentration_) &&
+        (_hyperx->concentration <= max_concentration_) &&
+        (_hyperx->terminals >= min_terminals_) &&
+        (_hyperx->terminals <= max_terminals_) &&
+        (_hyperx->router_radix >= min_radix_) &&
+        (_hyperx->router_radix <= max_radix_);
+  _hyperx->channels = 0;
+  ok &= (cost_function_->classes() == 0) ||
+        (cost_function_->classify(*_hyperx) < cost_function_->classes());
+  if (ok) {
+    _hyperx->channels = channelCount(*_hyperx);
+    _hyperx->cost = cost_function_->cost(*_hyperx);
+  }
+  trace(kTraceFeasible, TraceStage::kEvaluate,
+        ok ? TraceReason::kAccept : TraceReason::kInfeasible, *_hyperx);
+  return ok;
+}
+
+void Engine::setBudget(f64 _time_limit, u64 _node_limit) {
+  if (_time_limit < 0.0) {
+    throw std::runtime_error("timelimit must not be negative");
+  }
+  time_limit_ = (_time_limit == 0.0) ? F64_POS_INF : _time_limit;
+  node_limit_ = (_node_limit == 0) ? U64_MAX : _node_limit;
+}
+
+bool Engine::budgeted() const {
+  return (time_limit_ != F64_POS_INF) || (node_limit_ != U64_MAX);
+}
+
+void Engine::setImprovementHandler(
+    std::function<void(const Hyperx&)> _handler) {
+  improvement_handler_ = _handler;
+}
+
 void Engine::run() {
   hyperx_ = Hyperx();
   results_.clear();
+  classes_ = cost_function_->classes();
+  class_best_.assign(classes_, Hyperx());
+  curve_.clear();
+  if (spill_) {
+    spill_->clear();
+  }
+  coverage_ = Coverage();
+  exhausted_ = false;
+  start_ = std::chrono::steady_clock::now();
+
+  if (!budgeted()) {
+    collect_ = false;
+    stage1();
+  } else {
+    anytime();
+  }
+
+  coverage_.complete = !exhausted_;
+  coverage_.seconds = elapsed();
+}
 
+void Engine::count() {
+  hyperx_ = Hyperx();
+  counts_.clear();
+  for (u64 dims = min_dimensions_; dims <= max_dimensions_; dims++) {
+    counts_.push_back({dims, 0, 0, 0, 0});
+  }
+  coverage_ = Coverage();
+  exhausted_ = false;
+  collect_ = false;
+  counting_ = true;
   stage1();
+  counting_ = false;
+}
+
+const std::vector<SpaceCount>& Engine::counts() const {
+  return counts_;
 }
 
 const std::deque<Hyperx>& Engine::results() const {
   return results_;
 }
 
+const std::vector<Hyperx>& Engine::classBest() const {
+  return class_best_;
+}
+
+const std::map<f64, Hyperx>& Engine::bandwidthCurve() const {
+  return curve_;
+}
+
+u64 Engine::numResults() const {
+  return results_.size();
+}
+
+const Network& Engine::result(u64 _index) const {
+  return results_.at(_index);
+}
+
+std::string Engine::parameters(u64 _index) const {
+  const Hyperx& hyperx = results_.at(_index);
+  return "S=" + strop::vecString<u64>(hyperx.widths) +
+         " K=" + strop::vecString<u64>(hyperx.weights) +
+         " T=" + std::to_string(hyperx.concentration);
+}
+
+const Coverage& Engine::coverage() const {
+  return coverage_;
+}
+
+f64 Engine::elapsed() const {
+  return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start_)
+      .count();
+}
+
+f64 Engine::worstResult() const {
+  if (spill_) {
+    return spill_->threshold();
+  }
+  return (results_.size() == max_results_) ? results_.back().cost
+                                            : F64_POS_INF;
+}
+
+void Engine::curve() {
+  f64 bandwidth = *std::min_element(hyperx_.bisections.begin(),
+                                    hyperx_.bisections.end());
+
+  // a step at or above the bandwidth that is as cheap dominates
+  auto last = curve_.lower_bound(bandwidth);
+  if ((last != curve_.end()) && (last->second.cost <= hyperx_.cost)) {
+    return;
+  }
+
+  // replace the steps at or below the bandwidth that are as costly
+  if ((last != curve_.end()) && (last->first == bandwidth)) {
+    last++;
+  }
+  auto first = last;
+  while ((first != curve_.begin()) &&
+         (std::prev(first)->second.cost >= hyperx_.cost)) {
+    first--;
+  }
+  curve_.erase(first, last);
+  curve_.emplace(bandwidth, hyperx_);
+}
+
+void Engine::collect() {
+  // gather all width configurations that can produce results
+  collect_ = true;
+  regions_.clear();
+  region_widths_.clear();
+  stage1();
+  collect_ = false;
+}
+
+void Engine::anytime() {
+  collect();
+
+  // order the regions so the most promising are searched first. each region
+  //  is estimated by the cost of its smallest configuration that meets the
+  //  terminal and bandwidth targets, regions without a feasible estimate go
+  //  last, and ties prefer fewer routers then fewer dimensions.
+  for (Region& region : regions_) {
+    region.estimate = estimate(region);
+  }
+  std::stable_sort(regions_.begin(), regions_.end(),
+                   [](const Region& _lhs, const Region& _rhs) {
+                     if (_lhs.estimate != _rhs.estimate) {
+                       return _lhs.estimate < _rhs.estimate;
+                     }
+                     if (_lhs.routers != _rhs.routers) {
+                       return _lhs.routers < _rhs.routers;
+                     }
+                     return _lhs.dimensions < _rhs.dimensions;
+                   });
+  region_weights_.assign(region_widths_.size(), 1);
+
+  // search the regions round-robin in slices of nodes that double every
+  //  round so a single region can't consume the whole budget, each slice
+  //  resumes where the previous slice of that region stopped
+  u64 pending = regions_.size();
+  for (u64 slice = kSliceNodes; (pending > 0) && !exhausted_;
+       slice = (slice > (U64_MAX / 2)) ? U64_MAX : (slice * 2)) {
+    for (Region& region : regions_) {
+      if (exhausted_) {
+        break;
+      }
+      if (region.finished) {
+        continue;
+      }
+      std::vector<u64>::iterator widths = region_widths_.begin() +
+                                          region.offset;
+      std::vector<u64>::iterator weights = region_weights_.begin() +
+                                           region.offset;
+      hyperx_.dimensions = region.dimensions;
+      hyperx_.widths.assign(widths, widths + region.dimensions);
+      hyperx_.routers = region.routers;
+      resume_concentration_ = region.resume;
+      if (region.resume > 0) {
+        resume_weights_.assign(weights, weights + region.dimensions);
+        resume_ldim_ = region.ldim;
+      }
+      slice_end_ = (coverage_.nodes > (U64_MAX - slice)) ?
+          U64_MAX : (coverage_.nodes + slice);
+      sliced_ = false;
+      stage2();
+      if (sliced_) {
+        region.resume = resume_concentration_;
+        region.ldim = resume_ldim_;
+        std::copy(resume_weights_.begin(), resume_weights_.end(), weights);
+        resume_concentration_ = 0;
+        resume_weights_.clear();
+      } else if (!exhausted_) {
+        region.finished = true;
+        pending--;
+        coverage_.regions_searched++;
+      }
+    }
+  }
+  slice_end_ = U64_MAX;
+  sliced_ = false;
+  resume_concentration_ = 0;
+  resume_weights_.clear();
+  regions_.clear();
+  region_widths_.clear();
+  region_weights_.clear();
+}
+
+f64 Engine::estimate(const Region& _region) const {
+  // probe the fewest terminals per router that reach the terminal target
+  Hyperx probe;
+  probe.dimensions = _region.dimensions;
+  probe.widths.assign(region_widths_.begin() + _region.offset,
+                      region_widths_.begin() + _region.offset +
+                          _region.dimensions);
+  probe.routers = _region.routers;
+  probe.concentration = std::max(
+      min_concentration_, (min_terminals_ + probe.routers - 1) /
+                              probe.routers);
+  probe.terminals = probe.routers * probe.concentration;
+
+  // use the smallest weights that reach the minimum bandwidth
+  std::vector<u64> max_weights;
+  weightLimits(probe, &max_weights);
+  probe.weights.resize(probe.dimensions, 1);
+  u64 heaviest = 1;
+  for (u64 dim = 0; dim < probe.dimensions; dim++) {
+    u64 width = probe.widths.at(dim);
+    u64& weight = probe.weights.at(dim);
+    while ((weight < max_weights.at(dim)) &&
+           ((width * weight) / (2.0 * probe.concentration) < min_bandwidth_)) {
+      weight++;
+    }
+    heaviest = std::max(heaviest, weight);
+  }
+  if (fixed_weight_) {
+    probe.weights.assign(probe.dimensions, heaviest);
+  }
+  return evaluate(&probe) ? probe.cost : F64_POS_INF;
+}
+
+void Engine::region() {
+  // skip width configurations that can't reach the minimum terminal count
+  //  even with the maximum concentration allowed by the radix
+  u64 base_radix = 0;
+  for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
+    base_radix += hyperx_.widths.at(dim) - 1;
+  }
+  u64 max_concentration =
+      std::min(max_concentration_, max_radix_ - base_radix);
+  if (max_concentration < min_concentration_ ||
+      hyperx_.routers * max_concentration < min_terminals_) {
+    trace(kTraceSkip, TraceStage::kStage1,
+          (max_concentration < min_concentration_)
+              ? TraceReason::kConcentration
+              : TraceReason::kTerminalsLow,
+          hyperx_);
+    return;
+  }
+
+  coverage_.regions++;
+  if (counting_) {
+    counts_.at(hyperx_.dimensions - min_dimensions_).regions++;
+  }
+  if (collect_) {
+    regions_.push_back({hyperx_.routers, hyperx_.dimensions,
+                        region_widths_.size(), F64_POS_INF, 0, 0, false});
+    region_widths_.insert(region_widths_.end(), hyperx_.widths.begin(),
+                          hyperx_.widths.end());
+  } else {
+    stage2();
+    coverage_.regions_searched++;
+  }
+}
+
 void Engine::stage1() {
   /*
    * loop over the number of dimensions
@@ -138,68 +581,60 @@ void Engine::stage1() {
       break;
     }
 
-    if (HSE_DEBUG >= 6) {
-      printf("1: dimensions=%lu max_width=%lu\n", hyperx_.dimensions,
-             max_width);
-    }
-
     /*
      * generate possible dimension widths (S)
      */
     hyperx_.widths.clear();
     hyperx_.widths.resize(hyperx_.dimensions, 2);
-    while (true) {
-      // determine the number of routers
-      hyperx_.routers = 1;
-      u64 base_radix = 1;  // minimum current radix
-      for (u64 d = 0; d < hyperx_.widths.size(); d++) {
-        hyperx_.routers *= hyperx_.widths.at(d);
-        base_radix += hyperx_.widths.at(d) - 1;
-      }
+    trace(kTraceStage1, TraceStage::kStage1, TraceReason::kEnter, hyperx_);
+    widths(0, 1, 1, max_width);
+  }
+}
 
-      // find reasons to skip this case
-      //  expr 1: at minimum, there would be 1 terminal per router
-      //  expr 2: check minimum current router radix
-      if ((hyperx_.routers <= max_terminals_) && (base_radix <= max_radix_)) {
-        // if this configuration appears to work so far, use it
-        stage2();
-      } else if (HSE_DEBUG >= 7) {
-        printf("1s: SKIPPING S=%s\n",
-               strop::vecString<u64>(hyperx_.widths).c_str());
-      }
+void Engine::widths(u64 _dim, u64 _routers, u64 _base_radix,
+                    u64 _max_width) {
+  // widths are generated in non-decreasing order. every remaining dimension
+  //  will be at least as wide as this one, which bounds the number of routers
+  //  and the base radix of all configurations below this point.
+  u64 remaining = hyperx_.dimensions - _dim;
+  u64 first = (_dim == 0) ? 2 : hyperx_.widths.at(_dim - 1);
+  for (u64 width = first; width <= _max_width; width++) {
+    // find reasons to stop
+    //  expr 1: at minimum, there would be 1 terminal per router
+    //  expr 2: check minimum current router radix
+    u64 routers = _routers;
+    bool too_many_routers = false;
+    for (u64 rem = 0; rem < remaining && !too_many_routers; rem++) {
+      too_many_routers = __builtin_mul_overflow(routers, width, &routers) ||
+                         (routers > max_terminals_);
+    }
+    u64 base_radix = _base_radix + remaining * (width - 1);
+    if (too_many_routers || (base_radix > max_radix_)) {
+      // wider configurations are only larger
+      break;
+    }
 
-      // detect when done
-      if (hyperx_.widths.at(0) == max_width) {
-        break;
+    if (fixed_width_) {
+      // FbFly
+      for (u64 d = 0; d < hyperx_.dimensions; d++) {
+        hyperx_.widths.at(d) = width;
       }
-
-      // find the next widths configuration
-      if (!fixed_width_) {
-        // HyperX
-        u64 ndim = U64_MAX;  // next dimension to increment
-        for (u64 invdim = 0; invdim < hyperx_.dimensions; invdim++) {
-          ndim = hyperx_.dimensions - invdim - 1;
-          if (hyperx_.widths.at(ndim) == max_width) {
-            continue;
-          } else {
-            break;
-          }
-        }
-
-        // increment this dimension
-        hyperx_.widths.at(ndim)++;
-
-        // all inferior dimensions reset
-        for (u64 d = ndim + 1; d < hyperx_.dimensions; d++) {
-          hyperx_.widths.at(d) = hyperx_.widths.at(ndim);
-        }
+      hyperx_.routers = routers;
+      region();
+    } else {
+      // HyperX
+      hyperx_.widths.at(_dim) = width;
+      if (remaining == 1) {
+        hyperx_.routers = routers;
+        region();
       } else {
-        // FbFly
-        for (u64 d = 0; d < hyperx_.dimensions; d++) {
-          hyperx_.widths.at(d)++;
-        }
+        widths(_dim + 1, _routers * width, _base_radix + width - 1,
+               _max_width);
       }
     }
+    if (exhausted_) {
+      return;
+    }
   }
 }
 
@@ -208,10 +643,7 @@ void Engine::stage2() {
     assert(hyperx_.widths.at(dim) >= hyperx_.widths.at(dim - 1));
   }
 
-  if (HSE_DEBUG >= 5) {
-    printf("2: S=%s P=%lu\n", strop::vecString<u64>(hyperx_.widths).c_str(),
-           hyperx_.routers);
-  }
+  trace(kTraceStage2, TraceStage::kStage2, TraceReason::kEnter, hyperx_);
 
   // compute the base_radix (no terminals)
   u64 base_radix = 0;
@@ -219,204 +651,257 @@ void Engine::stage2() {
     base_radix += hyperx_.widths.at(dim) - 1;
   }
 
-  // try possible values for terminals per router ratio
-  for (hyperx_.concentration = min_concentration_;
-       hyperx_.concentration <= max_concentration_; hyperx_.concentration++) {
-    hyperx_.terminals = hyperx_.routers * hyperx_.concentration;
-    u64 base_radix2 = base_radix + hyperx_.concentration;
-    if ((hyperx_.terminals >= min_terminals_) &&
-        (hyperx_.terminals <= max_terminals_) && (base_radix2 <= max_radix_)) {
-      stage3();
-    } else {
-      if (HSE_DEBUG >= 7) {
-        printf("2s: SKIPPING S=%s P=%lu T=%lu\n",
-               strop::vecString<u64>(hyperx_.widths).c_str(), hyperx_.routers,
-               hyperx_.concentration);
+  // try possible values for terminals per router ratio, starting at the
+  //  first one that reaches the minimum number of terminals unless resuming
+  u64 first_concentration = firstConcentration(hyperx_);
+  if (resume_concentration_ > 0) {
+    first_concentration = resume_concentration_;
+    resume_concentration_ = 0;
+  }
+  for (hyperx_.concentration = first_concentration;
+       (hyperx_.concentration <= max_concentration_) && !exhausted_ &&
+       !sliced_;
+       hyperx_.concentration++) {
+    TraceReason reason;
+    bool more = checkConcentration(&hyperx_, base_radix, &reason);
+    if (reason == TraceReason::kAccept) {
+      if (!counting_) {
+        (this->*stage3_)();
+      } else {
+        countStage3();
       }
+    } else {
+      trace(kTraceSkip, TraceStage::kStage2, reason, hyperx_);
     }
-    if ((hyperx_.terminals > max_terminals_) || (base_radix2 > max_radix_)) {
+    if (!more) {
       break;
     }
   }
 }
 
-void Engine::stage3() {
-  if (HSE_DEBUG >= 4) {
-    printf("3: S=%s T=%lu N=%lu P=%lu\n",
-           strop::vecString<u64>(hyperx_.widths).c_str(), hyperx_.concentration,
-           hyperx_.terminals, hyperx_.routers);
+u64 Engine::firstConcentration(const Hyperx& _hyperx) const {
+  return std::max(min_concentration_,
+                  (min_terminals_ + _hyperx.routers - 1) / _hyperx.routers);
+}
+
+bool Engine::checkConcentration(Hyperx* _hyperx, u64 _base_radix,
+                                TraceReason* _reason) const {
+  _hyperx->terminals = _hyperx->routers * _hyperx->concentration;
+  u64 base_radix2 = _base_radix + _hyperx->concentration;
+  if (_hyperx->terminals < min_terminals_) {
+    *_reason = TraceReason::kTerminalsLow;
+  } else if (_hyperx->terminals > max_terminals_) {
+    *_reason = TraceReason::kTerminalsHigh;
+  } else if (base_radix2 > max_radix_) {
+    *_reason = TraceReason::kRadixHigh;
+  } else {
+    *_reason = TraceReason::kAccept;
   }
+  return (_hyperx->terminals <= max_terminals_) && (base_radix2 <= max_radix_);
+}
 
+u64 Engine::weightLimits(const Hyperx& _hyperx,
+                         std::vector<u64>* _max_weights) const {
   // find the base radix
-  u64 base_radix = hyperx_.concentration;
-  for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
-    base_radix += hyperx_.widths.at(dim) - 1;
+  u64 base_radix = _hyperx.concentration;
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    base_radix += _hyperx.widths.at(dim) - 1;
   }
   u64 delta_radix = max_radix_ - base_radix;
 
   // find the amount of weighting that is within maximum bounds
-  std::vector<u64> max_weights(hyperx_.dimensions, 1);
-  for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
-    u64 m = 1 + (delta_radix / (hyperx_.widths.at(dim) - 1));
-    if (m > max_weights.at(dim)) {
-      max_weights.at(dim) = std::min(max_weight_, m);
+  _max_weights->assign(_hyperx.dimensions, 1);
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    u64 m = 1 + (delta_radix / (_hyperx.widths.at(dim) - 1));
+    if (m > _max_weights->at(dim)) {
+      _max_weights->at(dim) = std::min(max_weight_, m);
     }
   }
-  if (HSE_DEBUG >= 4) {
-    printf("3: base_radix=%lu delta_radix=%lu, max_weights=%s\n", base_radix,
-           delta_radix, strop::vecString<u64>(max_weights).c_str());
-  }
-
-  // try finding acceptable weights
-  hyperx_.weights.clear();
-  hyperx_.weights.resize(hyperx_.dimensions, 1);
-  u64 ldim = 0;  // last incremented dimension
-  while (true) {
-    // compute router radix
-    hyperx_.router_radix = hyperx_.concentration;
-    for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
-      hyperx_.router_radix +=
-          ((hyperx_.widths.at(dim) - 1) * hyperx_.weights.at(dim));
-    }
+  return base_radix;
+}
 
-    bool too_small_radix = (hyperx_.router_radix < min_radix_);
-    bool too_big_radix = (hyperx_.router_radix > max_radix_);
+// adds without wrapping, counts beyond U64_MAX saturate
+static u64 addSat(u64 _a, u64 _b) {
+  u64 sum;
+  return __builtin_add_overflow(_a, _b, &sum) ? U64_MAX : sum;
+}
 
-    // test router radix
-    if ((too_small_radix || too_big_radix) && (HSE_DEBUG >= 6)) {
-      printf("3s: SKIPPING S=%s T=%lu N=%lu P=%lu K=%s R=%lu\n",
-             strop::vecString<u64>(hyperx_.widths).c_str(),
-             hyperx_.concentration, hyperx_.terminals, hyperx_.routers,
-             strop::vecString<u64>(hyperx_.weights).c_str(),
-             hyperx_.router_radix);
-    }
+// subtracts without wrapping, saturated counts stay saturated
+static u64 subSat(u64 _a, u64 _b) {
+  if (_a == U64_MAX) {
+    return U64_MAX;
+  }
+  return (_a > _b) ? (_a - _b) : 0;
+}
 
-    // if not already skipped, compute bisection bandwidth
-    bool too_small_bandwidth = false;
-    bool too_big_bandwidth = false;
-    if (!too_small_radix && !too_big_radix) {
-      hyperx_.bisections.clear();
-      hyperx_.bisections.resize(hyperx_.dimensions, 0.0);
-      f64 smallest_bandwidth = F64_POS_INF;
-      f64 largest_bandwidth = F64_NEG_INF;
-      for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
-        hyperx_.bisections.at(dim) =
-            (hyperx_.widths.at(dim) * hyperx_.weights.at(dim)) /
-            (2.0 * hyperx_.concentration);
-        if (hyperx_.bisections.at(dim) < smallest_bandwidth) {
-          smallest_bandwidth = hyperx_.bisections.at(dim);
-        }
-        if (hyperx_.bisections.at(dim) > largest_bandwidth) {
-          largest_bandwidth = hyperx_.bisections.at(dim);
-        }
-      }
-      if (smallest_bandwidth < min_bandwidth_) {
-        too_small_bandwidth = true;
-        if (HSE_DEBUG >= 7) {
-          printf("3s: SKIPPING S=%s T=%lu N=%lu P=%lu K=%s R=%lu B=%s\n",
-                 strop::vecString<u64>(hyperx_.widths).c_str(),
-                 hyperx_.concentration, hyperx_.terminals, hyperx_.routers,
-                 strop::vecString<u64>(hyperx_.weights).c_str(),
-                 hyperx_.router_radix,
-                 strop::vecString<f64>(hyperx_.bisections).c_str());
-        }
-      } else if (largest_bandwidth > max_bandwidth_) {
-        too_big_bandwidth = true;
-        if (HSE_DEBUG >= 7) {
-          printf("3s: SKIPPING S=%s T=%lu N=%lu P=%lu K=%s R=%lu B=%s\n",
-                 strop::vecString<u64>(hyperx_.widths).c_str(),
-                 hyperx_.concentration, hyperx_.terminals, hyperx_.routers,
-                 strop::vecString<u64>(hyperx_.weights).c_str(),
-                 hyperx_.router_radix,
-                 strop::vecString<f64>(hyperx_.bisections).c_str());
-        }
-      }
-    }
+// the bisection computation used by stage3()
+static f64 bisection(u64 _width, u64 _weight, u64 _concentration) {
+  return (_width * _weight) / (2.0 * _concentration);
+}
 
-    // if passed all tests, send to next stage
-    if (!too_small_radix && !too_big_bandwidth && !too_big_radix &&
-        !too_small_bandwidth) {
-      stage4();
-    }
+void Engine::countStage3() {
+  SpaceCount& count = counts_.at(hyperx_.dimensions - min_dimensions_);
+  count.stage3s++;
 
-    // detect when done, if the last dimension was incremented then
-    //  subsequentally skipped due to too large of router radix
-    if ((too_big_radix) && (ldim == (hyperx_.dimensions - 1))) {
-      break;
+  std::vector<u64>& max_weights = count_max_weights_;
+  u64 base_radix = weightLimits(hyperx_, &max_weights);
+  u64 delta_radix = max_radix_ - base_radix;
+  u64 channel_sum = base_radix - hyperx_.concentration;  // sum of (S-1)
+  u64 dims = hyperx_.dimensions;
+  u64 conc = hyperx_.concentration;
+
+  // stage3() stops after the first all-equal weight configuration
+  //  (w, ..., w) that exceeds the maximum radix
+  u64 break_weight = ((max_radix_ - conc) / channel_sum) + 1;
+
+  // find the weights allowed by the bandwidth limits in each dimension
+  std::vector<u64>& lo = count_lo_;
+  std::vector<u64>& hi = count_hi_;
+  lo.resize(dims);
+  hi.resize(dims);
+  for (u64 dim = 0; dim < dims; dim++) {
+    u64 width = hyperx_.widths.at(dim);
+    u64 l = std::max<u64>(
+        1, static_cast<u64>(min_bandwidth_ * 2.0 * conc / width));
+    while ((l > 1) && (bisection(width, l - 1, conc) >= min_bandwidth_)) {
+      l--;
     }
-    // find the next weights configuration
-    if (!fixed_weight_) {
-      // HyperX
-      u64 ndim = U64_MAX;  // next dimension to increment
-      for (ndim = 0; ndim < hyperx_.dimensions; ndim++) {
-        if (hyperx_.weights.at(ndim) == max_weights.at(ndim)) {
-          continue;
-        } else {
-          break;
-        }
-      }
-      if (ndim == hyperx_.dimensions) {
-        break;
-      }
-      hyperx_.weights.at(ndim)++;
-      ldim = ndim;
-      for (u64 d = 0; ndim != 0 && d < ndim; d++) {
-        hyperx_.weights.at(d) = hyperx_.weights.at(ndim);
-      }
-    } else {
-      // FbFly
-      for (u64 d = 0; d < hyperx_.dimensions; d++) {
-        hyperx_.weights.at(d)++;
+    while (bisection(width, l, conc) < min_bandwidth_) {
+      l++;
+    }
+    u64 h = fixed_weight_ ? break_weight : max_weights.at(dim);
+    if (max_bandwidth_ != F64_POS_INF) {
+      h = std::min(
+          h, static_cast<u64>(max_bandwidth_ * 2.0 * conc / width) + 1);
+      while ((h > 0) && (bisection(width, h, conc) > max_bandwidth_)) {
+        h--;
       }
-      ldim = hyperx_.dimensions - 1;
     }
+    lo.at(dim) = l;
+    hi.at(dim) = h;
   }
-}
 
-void Engine::stage4() {
-  for (u64 dim = 1; dim < hyperx_.dimensions; dim++) {
-    assert(hyperx_.weights.at(dim) <= hyperx_.weights.at(dim - 1));
+  // the extra radix above all weights being 1 must reach the minimum radix
+  //  without exceeding the maximum radix
+  u64 min_extra = (min_radix_ > base_radix) ? (min_radix_ - base_radix) : 0;
+
+  if (fixed_weight_) {
+    // FbFly: one weight in all dimensions, every value up to the break
+    count.nodes = addSat(count.nodes, break_weight);
+    u64 l = 1 + ((min_extra + channel_sum - 1) / channel_sum);
+    u64 h = break_weight - 1;
+    for (u64 dim = 0; dim < dims; dim++) {
+      l = std::max(l, lo.at(dim));
+      h = std::min(h, hi.at(dim));
+    }
+    if (h >= l) {
+      count.feasible = addSat(count.feasible, h - l + 1);
+    }
+    return;
   }
 
-  if (HSE_DEBUG >= 3) {
-    printf("4: S=%s T=%lu N=%lu K=%s B=%s\n",
-           strop::vecString<u64>(hyperx_.widths).c_str(), hyperx_.concentration,
-           hyperx_.terminals, strop::vecString<u64>(hyperx_.weights).c_str(),
-           strop::vecString<f64>(hyperx_.bisections).c_str());
+  // HyperX: the odometer visits every non-increasing weight configuration
+  //  within max_weights whose last weight is below the break weight, plus the
+  //  breaking configuration itself. visited[p] counts the configurations of
+  //  the remaining dimensions whose first weight is at most p.
+  u64 top = max_weights.at(0);
+  u64 last_max = std::min(max_weights.at(dims - 1), break_weight - 1);
+  std::vector<u64>& visited = count_visited_;
+  std::vector<u64>& next = count_next_;
+  visited.assign(top + 1, 0);
+  next.resize(top + 1);
+  for (u64 p = 0; p <= top; p++) {
+    next.at(p) = std::min(p, last_max);
   }
-
-  // compute the number of channels
-  hyperx_.channels = hyperx_.terminals;
-  for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
-    u64 triNum = hyperx_.widths.at(dim);
-    triNum = (triNum * (triNum - 1)) / 2;
-    u64 dim_channels = hyperx_.weights.at(dim) * triNum;
-    for (u64 dim2 = 0; dim2 < hyperx_.dimensions; dim2++) {
-      if (dim2 != dim) {
-        dim_channels *= hyperx_.widths.at(dim2);
+  for (u64 dim = dims - 1; dim-- > 0;) {
+    for (u64 p = 1; p <= top; p++) {
+      visited.at(p) = visited.at(p - 1);
+      if (p <= max_weights.at(dim)) {
+        visited.at(p) = addSat(visited.at(p), next.at(p));
       }
     }
-    hyperx_.channels += dim_channels;
+    std::swap(visited, next);
   }
-
-  stage5();
-}
-
-void Engine::stage5() {
-  if (HSE_DEBUG >= 2) {
-    printf("5: S=%s T=%lu N=%lu P=%lu K=%s R=%lu B=%s\n",
-           strop::vecString<u64>(hyperx_.widths).c_str(), hyperx_.concentration,
-           hyperx_.terminals, hyperx_.routers,
-           strop::vecString<u64>(hyperx_.weights).c_str(), hyperx_.router_radix,
-           strop::vecString<f64>(hyperx_.bisections).c_str());
+  count.nodes = addSat(count.nodes, next.at(top));
+  if (break_weight <= max_weights.at(dims - 1)) {
+    count.nodes = addSat(count.nodes, 1);
   }
 
-  hyperx_.cost = cost_function_->cost(hyperx_);
-
-  results_.push_back(hyperx_);
-  std::sort(results_.begin(), results_.end(), comparator_);
+  // feasible configurations need every weight within its bandwidth limits
+  for (u64 dim = 0; dim < dims; dim++) {
+    if (lo.at(dim) > hi.at(dim)) {
+      return;
+    }
+  }
+  if (min_extra > delta_radix) {
+    return;
+  }
+  if (dims == 1) {
+    u64 c = channel_sum;
+    u64 l = std::max(lo.at(0), 1 + ((min_extra + c - 1) / c));
+    u64 h = std::min(hi.at(0), 1 + (delta_radix / c));
+    if (h >= l) {
+      count.feasible = addSat(count.feasible, h - l + 1);
+    }
+    return;
+  }
 
-  if (results_.size() > max_results_) {
-    results_.pop_back();
+  // the remaining dimensions are counted over (p, r) where p bounds the
+  //  weight of the dimension (non-increasing weights) and r is the extra
+  //  radix still available:
+  //   table[p][r] = table[p-1][r] + later[p][r - (S-1)*(p-1)]
+  //  the last dimension has a closed form and the first dimension only needs
+  //  the row of its largest weight.
+  u64 cols = delta_radix + 1;
+  std::vector<u64>& later = count_later_;
+  std::vector<u64>& table = count_table_;
+  u64 rows = hi.at(dims - 2) + 1;
+  later.resize(rows * cols);
+  {
+    u64 c = hyperx_.widths.at(dims - 1) - 1;
+    u64 l = lo.at(dims - 1);
+    for (u64 p = 0; p < rows; p++) {
+      u64 h = std::min(p, hi.at(dims - 1));
+      for (u64 r = 0; r < cols; r++) {
+        u64 hr = std::min(h, 1 + (r / c));
+        later[p * cols + r] = (hr >= l) ? (hr - l + 1) : 0;
+      }
+    }
+  }
+  for (u64 dim = dims - 2; dim > 0; dim--) {
+    u64 c = hyperx_.widths.at(dim) - 1;
+    rows = hi.at(dim - 1) + 1;
+    table.resize(rows * cols);
+    std::fill(table.begin(), table.begin() + cols, 0);
+    for (u64 p = 1; p < rows; p++) {
+      u64* row = &table[p * cols];
+      const u64* prev = row - cols;
+      if ((p < lo.at(dim)) || (p > hi.at(dim))) {
+        std::copy(prev, prev + cols, row);
+        continue;
+      }
+      u64 used = c * (p - 1);
+      const u64* sub = &later[p * cols];
+      std::copy(prev, prev + std::min(used, cols), row);
+      for (u64 r = used; r < cols; r++) {
+        row[r] = addSat(prev[r], sub[r - used]);
+      }
+    }
+    std::swap(later, table);
+  }
+  u64 c = hyperx_.widths.at(0) - 1;
+  u64 feasible_count = 0;
+  for (u64 k = lo.at(0); k <= hi.at(0); k++) {
+    u64 used = c * (k - 1);
+    if (used > delta_radix) {
+      break;
+    }
+    feasible_count = addSat(feasible_count,
+                            later[k * cols + (delta_radix - used)]);
+    if ((min_extra > 0) && (used <= min_extra - 1)) {
+      feasible_count = subSat(feasible_count,
+                              later[k * cols + (min_extra - 1 - used)]);
+    }
   }
+  count.feasible = addSat(count.feasible, feasible_count);
 }
@@ -31,22 +31,24 @@
 #ifndef SEARCH_ENGINE_H_
 #define SEARCH_ENGINE_H_
 
+#include <chrono>
 #include <deque>
+#include <functional>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "prim/prim.h"
+#include "search/Network.h"
+#include "search/ResultSpill.h"
+#include "search/Searcher.h"
+#include "search/Trace.h"
 
-struct Hyperx {
-  u64 dimensions;               // L
-  std::vector<u64> widths;      // S
-  u64 routers;                  // P
-  u64 concentration;            // T
-  u64 terminals;                // N
-  std::vector<u64> weights;     // K
-  u64 router_radix;             // R
-  std::vector<f64> bisections;  // B
-  u64 channels;
-  f64 cost;
+struct Hyperx : public Network {
+  u64 dimensions;            // L
+  std::vector<u64> widths;   // S
+  u64 concentration;         // T
+  std::vector<u64> weights;  // K
 };
 
 class CostFunction {
@@ -54,14 +56,57 @@ class CostFunction {
   CostFunction();
   virtual ~CostFunction();
   virtual f64 cost(const Hyperx& _hyperx) const = 0;
+
+  // costs a network of any topology family from its common properties. the
+  //  default throws as not all cost functions support other families.
+  virtual f64 networkCost(const Network& _network) const;
+
+  // a lower bound on the cost of the HyperX for any weights between 1 and
+  //  '_max_weights', letting stage3() skip weights that can't be results. the
+  //  default gives no bound.
+  virtual f64 lowerBound(const Hyperx& _hyperx,
+                         const std::vector<u64>& _max_weights) const;
+
+  // cost functions may sort configurations into classes (e.g., the router
+  //  model used), the engine then keeps the best configuration of each class.
+  //  classify() returns U64_MAX for configurations of no class. the default
+  //  has no classes.
+  virtual u64 classes() const;
+  virtual u64 classify(const Hyperx& _hyperx) const;
+};
+
+// properties of a cost function type that let the engine skip work. cost
+//  functions that don't read the bisections specialize this so stage3() only
+//  checks the bandwidth limits and results get their bisections when kept.
+template <typename Cost>
+struct CostTraits {
+  static constexpr bool kReadsBisections = true;
+};
+
+struct Coverage {
+  bool complete;         // the whole search space was searched
+  u64 nodes;             // weight configurations visited
+  u64 regions;           // width configurations (S) eligible for searching
+  u64 regions_searched;  // width configurations completely searched
+  f64 seconds;           // elapsed search time
+};
+
+struct SpaceCount {
+  u64 dimensions;
+  u64 regions;   // width configurations (S)
+  u64 stage3s;   // width and concentration pairs (S, T) searched by stage3()
+  u64 nodes;     // weight configurations visited by stage3()
+  u64 feasible;  // configurations within all limits (i.e., reaching stage4())
 };
 
 class Comparator {
  public:
-  bool operator()(const Hyperx& _lhs, const Hyperx& _rhs) const;
+  bool operator()(const Network& _lhs, const Network& _rhs) const;
 };
 
-class Engine {
+class Engine : public Searcher {
+  friend class Cursor;
+
  public:
   Engine(u64 _min_dimensions, u64 _max_dimensions, u64 _min_radix,
          u64 _max_radix, u64 _min_Concentration, u64 _max_concentration,
@@ -71,10 +116,99 @@ class Engine {
          const CostFunction* _cost_function);
   ~Engine();
 
-  void run();
+  std::string family() const override;
+
+  u64 minDimensions() const;
+  u64 maxDimensions() const;
+  u64 minRadix() const;
+  u64 maxRadix() const;
+  u64 minConcentration() const;
+  u64 maxConcentration() const;
+  u64 minTerminals() const;
+  u64 maxTerminals() const;
+  f64 minBandwidth() const;
+  f64 maxBandwidth() const;
+  u64 maxWidth() const;
+  u64 maxWeight() const;
+  bool fixedWidth() const;
+  bool fixedWeight() const;
+  u64 maxResults() const;
+  const CostFunction* costFunction() const;
+
+  // the number of channels, including terminal channels, of a configuration
+  //  with its terminals computed
+  static u64 channelCount(const Hyperx& _hyperx);
+
+  // computes the derived fields of a configuration given its dimensions,
+  //  widths, weights, and concentration, then checks it against all limits.
+  //  the cost is computed for configurations within the limits.
+  bool evaluate(Hyperx* _hyperx) const;
+
+  // limits the search to a time and/or node (weight configuration) budget.
+  //  a budgeted search visits the most promising width configurations first
+  //  and returns the best results found when the budget runs out. zero means
+  //  unlimited.
+  void setBudget(f64 _time_limit, u64 _node_limit);
+  bool budgeted() const;
+
+  // called with the new best result every time it improves
+  void setImprovementHandler(std::function<void(const Hyperx&)> _handler);
+
+  // records search events to the tracer, null disables tracing
+  void setTracer(Tracer* _tracer);
+
+  // also keeps the cost/bandwidth trade-off curve: the cheapest configuration
+  //  for every minimum bandwidth at or above the engine's. this disables the
+  //  lower bound pruning, which only knows the results.
+  void setBandwidthCurve(bool _enabled);
+
+  // keeps the results in the spill instead of results(), for result counts
+  //  too large to hold in memory. null keeps them in memory. the improvement
+  //  handler isn't called when spilling.
+  void setResultSpill(ResultSpill* _spill);
+
+  void run() override;
   const std::deque<Hyperx>& results() const;
+  // the best configuration of each class of the cost function, classes
+  //  without configurations have no dimensions
+  const std::vector<Hyperx>& classBest() const;
+  // the steps of the bandwidth curve keyed by their smallest bisection. the
+  //  cheapest configuration for a bandwidth 'b' is the first step at or
+  //  above 'b', costs increase with the bandwidth.
+  const std::map<f64, Hyperx>& bandwidthCurve() const;
+  u64 numResults() const override;
+  const Network& result(u64 _index) const override;
+  std::string parameters(u64 _index) const override;
+
+  // sizes the search space per dimension count without enumerating weights
+  void count();
+  const std::vector<SpaceCount>& counts() const;
+
+  const Coverage& coverage() const;
+
+ protected:
+  // runs stage3() through stage5() with 'Cost', the exact type of the cost
+  //  function, so its cost is called directly
+  template <typename Cost>
+  void specialize();
 
  private:
+  // trace levels of the search events, lower levels are less frequent
+  static constexpr u8 kTraceCosted = 2;
+  static constexpr u8 kTraceFeasible = 3;
+  static constexpr u8 kTraceStage3 = 4;
+  static constexpr u8 kTraceStage2 = 5;
+  static constexpr u8 kTraceStage1 = 6;
+  static constexpr u8 kTraceRadixSkip = 6;
+  static constexpr u8 kTraceSkip = 7;
+
+  // the clock is only sampled every this many nodes during a budgeted search
+  static constexpr u64 kClockInterval = 1024;
+
+  // nodes of the first slice of every region in a budgeted search, each
+  //  round over the regions doubles the slice
+  static constexpr u64 kSliceNodes = 4096;
+
   u64 min_dimensions_;
   u64 max_dimensions_;
   u64 min_radix_;
@@ -94,12 +228,116 @@ class Engine {
   Comparator comparator_;
   Hyperx hyperx_;
   std::deque<Hyperx> results_;
+  u64 classes_;
+  std::vector<Hyperx> class_best_;
+  bool bandwidth_curve_;
+  std::map<f64, Hyperx> curve_;
+  ResultSpill* spill_;
+
+  // anytime search
+  struct Region {
+    u64 routers;
+    u64 dimensions;
+    u64 offset;     // into region_widths_ and region_weights_
+    f64 estimate;   // cost of a probe configuration, infinite if infeasible
+    u64 resume;     // concentration to resume at, zero before the first slice
+    u64 ldim;       // last incremented dimension to resume with
+    bool finished;  // the region was completely searched
+  };
+  f64 time_limit_;
+  u64 node_limit_;
+  std::function<void(const Hyperx&)> improvement_handler_;
+  bool collect_;
+  bool exhausted_;
+  std::vector<Region> regions_;
+  std::vector<u64> region_widths_;
+  std::vector<u64> region_weights_;  // weights to resume at
+
+  // a slice of a region stops once this many nodes have been visited and
+  //  records where it stopped in the resume state
+  u64 slice_end_;
+  bool sliced_;
+  u64 resume_concentration_;         // zero starts at the first
+  std::vector<u64> resume_weights_;  // empty starts at the first
+  u64 resume_ldim_;
+  std::chrono::steady_clock::time_point start_;
+  Coverage coverage_;
+
+  // counting
+  bool counting_;
+  std::vector<SpaceCount> counts_;
+  std::vector<u64> count_max_weights_;
+  std::vector<u64> count_lo_;
+  std::vector<u64> count_hi_;
+  std::vector<u64> count_visited_;
+  std::vector<u64> count_next_;
+  std::vector<u64> count_later_;
+  std::vector<u64> count_table_;
+
+  // tracing
+  Tracer* tracer_;
+
+  // the stage3() instantiation for the cost function type
+  void (Engine::*stage3_)();
+
+  void trace(u8 _level, TraceStage _stage, TraceReason _reason,
+             const Hyperx& _hyperx) const;
+  f64 elapsed() const;
+  f64 worstResult() const;
+  void curve();
+  void collect();
+  void anytime();
+  f64 estimate(const Region& _region) const;
+  void region();
 
   void stage1();
+  void widths(u64 _dim, u64 _routers, u64 _base_radix, u64 _max_width);
   void stage2();
+  u64 weightLimits(const Hyperx& _hyperx,
+                   std::vector<u64>* _max_weights) const;
+
+  // the steps of stage2() and stage3() shared with Cursor
+  // the first concentration that reaches the minimum number of terminals
+  u64 firstConcentration(const Hyperx& _hyperx) const;
+  // computes the terminals, '_reason' is kAccept when they and the radix with
+  //  '_base_radix' (no terminals) are within the limits. returns false when
+  //  no larger concentration can be.
+  bool checkConcentration(Hyperx* _hyperx, u64 _base_radix,
+                          TraceReason* _reason) const;
+  // computes the router radix and, when 'kBisections', the bisections of the
+  //  weights. returns kAccept when they are within the limits, otherwise the
+  //  limit exceeded.
+  template <bool kBisections>
+  TraceReason checkWeights(Hyperx* _hyperx) const;
+  // moves to the next weights within '_max_weights' and sets '_ldim' to the
+  //  last incremented dimension. returns false when the weights are done,
+  //  including when the last weights exceeded the radix by incrementing the
+  //  last dimension ('_too_big_radix').
+  bool nextWeights(const std::vector<u64>& _max_weights, bool _too_big_radix,
+                   Hyperx* _hyperx, u64* _ldim) const;
+  template <typename Cost>
   void stage3();
+  void countStage3();
+  template <typename Cost>
   void stage4();
+  template <typename Cost>
   void stage5();
 };
 
+// an engine that calls its cost function as 'Cost' rather than through the
+//  virtual interface. 'Cost' must be the exact type of the cost function.
+template <typename Cost>
+class CostEngine : public Engine {
+ public:
+  CostEngine(u64 _min_dimensions, u64 _max_dimensions, u64 _min_radix,
+             u64 _max_radix, u64 _min_concentration, u64 _max_concentration,
+             u64 _min_terminals, u64 _max_terminals, f64 _min_bandwidth,
+             f64 _max_bandwidth, u64 _max_width, u64 _max_weight,
+             bool _fixed_width, bool _fixed_weight, u64 _max_results,
+             const Cost* _cost_function);
+  ~CostEngine();
+};
+
+#include "search/Engine.tcc"
+
 #endif  // SEARCH_ENGINE_H_
@@ -0,0 +1,302 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_ENGINE_H_
+#error "do not include this file directly, include Engine.h instead"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+// defined here so the stage instantiations inline it
+inline void Engine::trace(u8 _level, TraceStage _stage, TraceReason _reason,
+                          const Hyperx& _hyperx) const {
+  if ((tracer_ != nullptr) && tracer_->enabled(_level)) {
+    tracer_->record(_level, _stage, _reason, _hyperx);
+  }
+}
+
+template <typename Cost>
+void Engine::specialize() {
+  stage3_ = &Engine::stage3<Cost>;
+}
+
+template <typename Cost>
+void Engine::stage3() {
+  // find the base radix and the amount of weighting within maximum bounds
+  std::vector<u64> max_weights;
+  weightLimits(hyperx_, &max_weights);
+
+  // try finding acceptable weights, continuing where the last slice stopped
+  u64 ldim = 0;  // last incremented dimension
+  if (resume_weights_.empty()) {
+    hyperx_.weights.clear();
+    hyperx_.weights.resize(hyperx_.dimensions, 1);
+  } else {
+    hyperx_.weights.swap(resume_weights_);
+    resume_weights_.clear();
+    ldim = resume_ldim_;
+  }
+  trace(kTraceStage3, TraceStage::kStage3, TraceReason::kEnter, hyperx_);
+
+  // skip all weights when none can be cheaper than the current results nor
+  //  the best of any class
+  f64 worst = (max_results_ > 0) ? worstResult() : F64_POS_INF;
+  for (const Hyperx& best : class_best_) {
+    worst = std::max(worst,
+                     (best.dimensions == 0) ? F64_POS_INF : best.cost);
+  }
+  if (!bandwidth_curve_ && (worst != F64_POS_INF) &&
+      (cost_function_->lowerBound(hyperx_, max_weights) > worst)) {
+    trace(kTraceStage3, TraceStage::kStage3, TraceReason::kPruned, hyperx_);
+    return;
+  }
+
+  while (true) {
+    // stop this slice of the region where the next one can resume
+    if (coverage_.nodes >= slice_end_) {
+      sliced_ = true;
+      resume_concentration_ = hyperx_.concentration;
+      resume_weights_ = hyperx_.weights;
+      resume_ldim_ = ldim;
+      return;
+    }
+
+    // check the search budget
+    coverage_.nodes++;
+    if ((coverage_.nodes > node_limit_) ||
+        (((coverage_.nodes % kClockInterval) == 0) &&
+         (elapsed() >= time_limit_))) {
+      coverage_.nodes--;
+      exhausted_ = true;
+      return;
+    }
+
+    // test the router radix and bisection bandwidth, bisections are only
+    //  kept for cost functions that read them
+    TraceReason reason =
+        checkWeights<CostTraits<Cost>::kReadsBisections>(&hyperx_);
+    if (reason == TraceReason::kAccept) {
+      // if passed all tests, send to next stage
+      stage4<Cost>();
+    } else {
+      trace((reason == TraceReason::kRadixLow) ||
+                    (reason == TraceReason::kRadixHigh)
+                ? kTraceRadixSkip
+                : kTraceSkip,
+            TraceStage::kStage3, reason, hyperx_);
+    }
+
+    // find the next weights configuration
+    if (!nextWeights(max_weights, reason == TraceReason::kRadixHigh, &hyperx_,
+                     &ldim)) {
+      break;
+    }
+  }
+}
+
+template <bool kBisections>
+TraceReason Engine::checkWeights(Hyperx* _hyperx) const {
+  // compute router radix
+  _hyperx->router_radix = _hyperx->concentration;
+  for (u64 dim = 0; dim < _hyperx->dimensions; dim++) {
+    _hyperx->router_radix +=
+        ((_hyperx->widths.at(dim) - 1) * _hyperx->weights.at(dim));
+  }
+  if (_hyperx->router_radix < min_radix_) {
+    return TraceReason::kRadixLow;
+  }
+  if (_hyperx->router_radix > max_radix_) {
+    return TraceReason::kRadixHigh;
+  }
+
+  // compute bisection bandwidth
+  if (kBisections) {
+    _hyperx->bisections.clear();
+    _hyperx->bisections.resize(_hyperx->dimensions, 0.0);
+  }
+  f64 smallest_bandwidth = F64_POS_INF;
+  f64 largest_bandwidth = F64_NEG_INF;
+  for (u64 dim = 0; dim < _hyperx->dimensions; dim++) {
+    f64 bandwidth = (_hyperx->widths.at(dim) * _hyperx->weights.at(dim)) /
+                    (2.0 * _hyperx->concentration);
+    if (kBisections) {
+      _hyperx->bisections.at(dim) = bandwidth;
+    }
+    if (bandwidth < smallest_bandwidth) {
+      smallest_bandwidth = bandwidth;
+    }
+    if (bandwidth > largest_bandwidth) {
+      largest_bandwidth = bandwidth;
+    }
+  }
+  if (smallest_bandwidth < min_bandwidth_) {
+    return TraceReason::kBandwidthLow;
+  }
+  if (largest_bandwidth > max_bandwidth_) {
+    return TraceReason::kBandwidthHigh;
+  }
+  return TraceReason::kAccept;
+}
+
+inline bool Engine::nextWeights(const std::vector<u64>& _max_weights,
+                                bool _too_big_radix, Hyperx* _hyperx,
+                                u64* _ldim) const {
+  // detect when done, if the last dimension was incremented then
+  //  subsequentally skipped due to too large of router radix
+  if (_too_big_radix && (*_ldim == (_hyperx->dimensions - 1))) {
+    return false;
+  }
+  if (!fixed_weight_) {
+    // HyperX
+    u64 ndim = U64_MAX;  // next dimension to increment
+    for (ndim = 0; ndim < _hyperx->dimensions; ndim++) {
+      if (_hyperx->weights.at(ndim) != _max_weights.at(ndim)) {
+        break;
+      }
+    }
+    if (ndim == _hyperx->dimensions) {
+      return false;
+    }
+    _hyperx->weights.at(ndim)++;
+    *_ldim = ndim;
+    for (u64 d = 0; d < ndim; d++) {
+      _hyperx->weights.at(d) = _hyperx->weights.at(ndim);
+    }
+  } else {
+    // FbFly
+    for (u64 d = 0; d < _hyperx->dimensions; d++) {
+      _hyperx->weights.at(d)++;
+    }
+    *_ldim = _hyperx->dimensions - 1;
+  }
+  return true;
+}
+
+template <typename Cost>
+void Engine::stage4() {
+  for (u64 dim = 1; dim < hyperx_.dimensions; dim++) {
+    assert(hyperx_.weights.at(dim) <= hyperx_.weights.at(dim - 1));
+  }
+
+  trace(kTraceFeasible, TraceStage::kStage4, TraceReason::kAccept, hyperx_);
+
+  // compute the number of channels
+  hyperx_.channels = channelCount(hyperx_);
+
+  stage5<Cost>();
+}
+
+template <typename Cost>
+void Engine::stage5() {
+  // a known cost type is called directly, allowing it to be inlined
+  const Cost* cost_function = static_cast<const Cost*>(cost_function_);
+
+  // configurations of no class (e.g., fitting no router SKU) are only within
+  //  the engine's limits because they were widened for the classes
+  u64 cls = U64_MAX;
+  if (classes_ > 0) {
+    cls = cost_function->classify(hyperx_);
+    if (cls >= classes_) {
+      trace(kTraceCosted, TraceStage::kStage5, TraceReason::kUnclassified,
+            hyperx_);
+      return;
+    }
+  }
+
+  trace(kTraceCosted, TraceStage::kStage5, TraceReason::kAccept, hyperx_);
+  if constexpr (std::is_same<Cost, CostFunction>::value) {
+    hyperx_.cost = cost_function->cost(hyperx_);
+  } else {
+    hyperx_.cost = cost_function->Cost::cost(hyperx_);
+  }
+  bool improved = results_.empty() || (hyperx_.cost < results_.front().cost);
+
+  // the best of each class is kept besides the results
+  Hyperx* class_best = nullptr;
+  if ((classes_ > 0) && ((class_best_[cls].dimensions == 0) ||
+                          (hyperx_.cost < class_best_[cls].cost))) {
+    class_best = &class_best_[cls];
+  }
+
+  // results need the bisections skipped by stage3()
+  if (!CostTraits<Cost>::kReadsBisections &&
+      ((!spill_ && ((results_.size() < max_results_) ||
+                    (!results_.empty() &&
+                     (hyperx_.cost <= results_.back().cost)))) ||
+       class_best || bandwidth_curve_)) {
+    hyperx_.bisections.resize(hyperx_.dimensions);
+    for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
+      hyperx_.bisections.at(dim) =
+          (hyperx_.widths.at(dim) * hyperx_.weights.at(dim)) /
+          (2.0 * hyperx_.concentration);
+    }
+  }
+  if (class_best) {
+    *class_best = hyperx_;
+  }
+  if (bandwidth_curve_) {
+    curve();
+  }
+  if (spill_) {
+    spill_->add(hyperx_);
+    return;
+  }
+
+  results_.push_back(hyperx_);
+  std::sort(results_.begin(), results_.end(), comparator_);
+
+  if (results_.size() > max_results_) {
+    results_.pop_back();
+  }
+
+  if (improved && improvement_handler_ && !results_.empty()) {
+    improvement_handler_(results_.front());
+  }
+}
+
+template <typename Cost>
+CostEngine<Cost>::CostEngine(
+    u64 _min_dimensions, u64 _max_dimensions, u64 _min_radix, u64 _max_radix,
+    u64 _min_concentration, u64 _max_concentration, u64 _min_terminals,
+    u64 _max_terminals, f64 _min_bandwidth, f64 _max_bandwidth,
+    u64 _max_width, u64 _max_weight, bool _fixed_width, bool _fixed_weight,
+    u64 _max_results, const Cost* _cost_function)
+    : Engine(_min_dimensions, _max_dimensions, _min_radix, _max_radix,
+             _min_concentration, _max_concentration, _min_terminals,
+             _max_terminals, _min_bandwidth, _max_bandwidth, _max_width,
+             _max_weight, _fixed_width, _fixed_weight, _max_results,
+             _cost_function) {
+  this->template specialize<Cost>();
+}
+
+template <typename Cost>
+CostEngine<Cost>::~CostEngine() {}
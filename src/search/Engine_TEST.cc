@@ -0,0 +1,106 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Engine.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/RouterChannelCount.h"
+
+namespace {
+
+struct Limits {
+  u64 min_radix;
+  u64 max_radix;
+  u64 min_terminals;
+  u64 max_terminals;
+  f64 min_bandwidth;
+  f64 max_bandwidth;
+  bool fixed_width;
+  bool fixed_weight;
+};
+
+// counts the space of each dimension count and enumerates it by searching
+//  with every feasible configuration kept as a result
+void checkCount(const Limits& _limits) {
+  RouterChannelCount calc;
+  Engine counter(1, 4, _limits.min_radix, _limits.max_radix, 1, 32,
+                 _limits.min_terminals, _limits.max_terminals,
+                 _limits.min_bandwidth, _limits.max_bandwidth, 32, 32,
+                 _limits.fixed_width, _limits.fixed_weight, 0, &calc);
+  counter.count();
+  ASSERT_EQ(counter.counts().size(), 4u);
+
+  u64 total = 0;
+  for (const SpaceCount& count : counter.counts()) {
+    u64 dims = count.dimensions;
+    Engine engine(dims, dims, _limits.min_radix, _limits.max_radix, 1, 32,
+                  _limits.min_terminals, _limits.max_terminals,
+                  _limits.min_bandwidth, _limits.max_bandwidth, 32, 32,
+                  _limits.fixed_width, _limits.fixed_weight, 1000000, &calc);
+    engine.run();
+    ASSERT_LT(engine.results().size(), 1000000u);
+    EXPECT_EQ(count.regions, engine.coverage().regions) << dims;
+    EXPECT_EQ(count.nodes, engine.coverage().nodes) << dims;
+    EXPECT_EQ(count.feasible, engine.results().size()) << dims;
+    EXPECT_LE(count.stage3s, count.nodes) << dims;
+    total += count.feasible;
+  }
+  EXPECT_GT(total, 0u);
+}
+
+}  // namespace
+
+TEST(Engine, count) {
+  checkCount({2, 24, 200, 500, 0.3, F64_POS_INF, false, false});
+}
+
+TEST(Engine, countMinRadix) {
+  checkCount({18, 24, 200, 500, 0.3, F64_POS_INF, false, false});
+}
+
+TEST(Engine, countMaxBandwidth) {
+  checkCount({2, 28, 100, 400, 0.4, 1.1, false, false});
+}
+
+TEST(Engine, countFixedWidth) {
+  checkCount({2, 32, 100, 2000, 0.3, F64_POS_INF, true, false});
+}
+
+TEST(Engine, countFixedWeight) {
+  checkCount({2, 32, 100, 600, 0.5, 2.0, false, true});
+}
+
+TEST(Engine, countLowBandwidth) {
+  checkCount({10, 16, 50, 200, 0.01, F64_POS_INF, false, false});
+}
@@ -0,0 +1,70 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_FAMILYENGINE_H_
+#define SEARCH_FAMILYENGINE_H_
+
+#include <deque>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/Network.h"
+#include "search/Searcher.h"
+
+// The shared part of the non-HyperX family searches. The limits, the cost
+//  function, and the number of results all come from the HyperX engine so
+//  that every family is searched under the same constraints.
+template <typename T>
+class FamilyEngine : public Searcher {
+ public:
+  explicit FamilyEngine(const Engine* _limits);
+  virtual ~FamilyEngine();
+
+  const std::deque<T>& results() const;
+  u64 numResults() const override;
+  const Network& result(u64 _index) const override;
+
+ protected:
+  // checks the terminal, radix, and bisection limits
+  bool withinLimits(const Network& _network) const;
+
+  // costs a candidate within the limits and keeps it if it is in the top-K
+  void consider(T* _candidate);
+
+  const Engine* limits_;
+  std::deque<T> results_;
+
+ private:
+  Comparator comparator_;
+};
+
+#include "search/FamilyEngine.tcc"
+
+#endif  // SEARCH_FAMILYENGINE_H_
@@ -0,0 +1,94 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_FAMILYENGINE_H_
+#error "do not include this file directly, include FamilyEngine.h instead"
+#endif
+
+#include <algorithm>
+
+template <typename T>
+FamilyEngine<T>::FamilyEngine(const Engine* _limits) : limits_(_limits) {}
+
+template <typename T>
+FamilyEngine<T>::~FamilyEngine() {}
+
+template <typename T>
+const std::deque<T>& FamilyEngine<T>::results() const {
+  return results_;
+}
+
+template <typename T>
+u64 FamilyEngine<T>::numResults() const {
+  return results_.size();
+}
+
+template <typename T>
+const Network& FamilyEngine<T>::result(u64 _index) const {
+  return results_.at(_index);
+}
+
+template <typename T>
+bool FamilyEngine<T>::withinLimits(const Network& _network) const {
+  if ((_network.terminals < limits_->minTerminals()) ||
+      (_network.terminals > limits_->maxTerminals()) ||
+      (_network.router_radix < limits_->minRadix()) ||
+      (_network.router_radix > limits_->maxRadix())) {
+    return false;
+  }
+  for (f64 bisection : _network.bisections) {
+    if ((bisection < limits_->minBandwidth()) ||
+        (bisection > limits_->maxBandwidth())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+void FamilyEngine<T>::consider(T* _candidate) {
+  if (limits_->maxResults() == 0) {
+    return;
+  }
+  _candidate->cost = limits_->costFunction()->networkCost(*_candidate);
+  if (_candidate->cost == F64_POS_INF) {
+    return;  // e.g., no router SKU fits
+  }
+  if ((results_.size() == limits_->maxResults()) &&
+      !comparator_(*_candidate, results_.back())) {
+    return;
+  }
+  results_.insert(std::upper_bound(results_.begin(), results_.end(),
+                                   *_candidate, comparator_),
+                  *_candidate);
+  if (results_.size() > limits_->maxResults()) {
+    results_.pop_back();
+  }
+}
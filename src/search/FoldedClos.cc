@@ -0,0 +1,159 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/FoldedClos.h"
+
+#include <algorithm>
+#include <cmath>
+
+FoldedClosEngine::FoldedClosEngine(const Engine* _limits)
+    : FamilyEngine<FoldedClos>(_limits) {}
+
+FoldedClosEngine::~FoldedClosEngine() {}
+
+std::string FoldedClosEngine::family() const {
+  return "fattree";
+}
+
+void FoldedClosEngine::run() {
+  results_.clear();
+  clos_ = FoldedClos();
+
+  /*
+   * loop over the number of levels, using the dimension limits
+   */
+  for (clos_.levels = limits_->minDimensions();
+       clos_.levels <= limits_->maxDimensions(); clos_.levels++) {
+    clos_.downs.assign(clos_.levels, 0);
+    clos_.ups.assign(clos_.levels, 0);
+    clos_.level_routers.assign(clos_.levels, 0);
+    clos_.bisections.assign(clos_.levels - 1, 0.0);
+    level(0, 1, 1);
+  }
+}
+
+std::string FoldedClosEngine::parameters(u64 _index) const {
+  // the same notation as fattree_tell.py (e.g., 8x4-6x3-10)
+  const FoldedClos& clos = results_.at(_index);
+  std::string str;
+  for (u64 lev = 0; lev < clos.levels; lev++) {
+    if (lev > 0) {
+      str += "-";
+    }
+    str += std::to_string(clos.downs.at(lev));
+    if (lev + 1 < clos.levels) {
+      str += "x" + std::to_string(clos.ups.at(lev));
+    }
+  }
+  return str;
+}
+
+void FoldedClosEngine::level(u64 _level, u64 _terminals, u64 _ups) {
+  // _terminals is the terminals per group below this level and _ups is the
+  //  routers per group at this level
+  u64 max_radix = limits_->maxRadix();
+  u64 min_down = (_level == 0)
+                     ? std::max<u64>(1, limits_->minConcentration())
+                     : 2;
+  u64 max_down = (_level == 0) ? limits_->maxConcentration() : max_radix;
+
+  if (_level + 1 == clos_.levels) {
+    // the top level only has down ports and sets the number of terminals
+    u64 first = std::max(
+        min_down, (limits_->minTerminals() + _terminals - 1) / _terminals);
+    u64 last = std::min(std::min(max_down, max_radix),
+                        limits_->maxTerminals() / _terminals);
+    for (u64 down = first; down <= last; down++) {
+      clos_.downs.at(_level) = down;
+      clos_.ups.at(_level) = 0;
+      evaluate();
+    }
+    return;
+  }
+
+  // every level above this one at least doubles the terminals
+  u64 growth = 1ul << std::min<u64>(63, clos_.levels - _level - 1);
+  for (u64 down = min_down; down < max_radix && down <= max_down; down++) {
+    u64 terminals;
+    if (__builtin_mul_overflow(_terminals, down, &terminals) ||
+        (terminals > limits_->maxTerminals() / growth)) {
+      break;
+    }
+    clos_.downs.at(_level) = down;
+
+    // the bisection of the next level is (routers per group) / (terminals per
+    //  group), start at or below the smallest meeting the minimum bandwidth.
+    //  more up than down ports would only add routers above full bisection.
+    u64 first_up = std::max<u64>(
+        1, static_cast<u64>(std::floor(limits_->minBandwidth() * terminals /
+                                       _ups)));
+    for (u64 up = first_up; (up <= down) && (down + up <= max_radix); up++) {
+      u64 ups;
+      if (__builtin_mul_overflow(_ups, up, &ups)) {
+        break;
+      }
+      clos_.ups.at(_level) = up;
+      level(_level + 1, terminals, ups);
+    }
+  }
+}
+
+void FoldedClosEngine::evaluate() {
+  clos_.terminals = 1;
+  for (u64 down : clos_.downs) {
+    clos_.terminals *= down;
+  }
+
+  clos_.routers = 0;
+  clos_.channels = 0;
+  clos_.router_radix = 0;
+  u64 group_terminals = 1;
+  u64 group_routers = 1;
+  f64 bisection = F64_POS_INF;
+  for (u64 lev = 0; lev < clos_.levels; lev++) {
+    if (lev > 0) {
+      bisection = std::min(bisection, static_cast<f64>(group_routers) /
+                                          group_terminals);
+      clos_.bisections.at(lev - 1) = bisection;
+    }
+    group_terminals *= clos_.downs.at(lev);
+    clos_.level_routers.at(lev) =
+        (clos_.terminals / group_terminals) * group_routers;
+    clos_.routers += clos_.level_routers.at(lev);
+    clos_.channels += clos_.downs.at(lev) * clos_.level_routers.at(lev);
+    clos_.router_radix = std::max(clos_.router_radix,
+                                  clos_.downs.at(lev) + clos_.ups.at(lev));
+    group_routers *= clos_.ups.at(lev);
+  }
+
+  if (withinLimits(clos_)) {
+    consider(&clos_);
+  }
+}
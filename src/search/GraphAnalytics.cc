@@ -0,0 +1,265 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/GraphAnalytics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+GraphAnalytics::GraphAnalytics(
+    const std::unordered_map<std::string, std::string>& _settings)
+    : populate_(1.0) {
+  for (const auto& setting : _settings) {
+    if (setting.first == "populate") {
+      populate_ = std::stod(setting.second);
+      if (!(populate_ > 0.0) || (populate_ > 1.0)) {
+        throw std::runtime_error("populate must be in (0, 1]");
+      }
+    } else {
+      throw std::runtime_error("unknown graph_analytics setting: " +
+                               setting.first);
+    }
+  }
+  fields_ = {"AvgHops", "Diameter", "PathDiversity"};
+  if (populate_ < 1.0) {
+    fields_.push_back("Populated");
+  }
+}
+
+GraphAnalytics::~GraphAnalytics() {}
+
+const std::vector<std::string>& GraphAnalytics::extFields() const {
+  return fields_;
+}
+
+std::unordered_map<std::string, std::string> GraphAnalytics::extValues(
+    const Hyperx& _hyperx) const {
+  // use the metrics of analyze() when available
+  Metrics metrics;
+  auto it = metrics_.find(key(_hyperx));
+  if (it != metrics_.end()) {
+    metrics = it->second;
+  } else {
+    metrics = measure(_hyperx);
+  }
+
+  char buf[32];
+  std::unordered_map<std::string, std::string> values;
+  snprintf(buf, sizeof(buf), "%.4f", metrics.average_hops);
+  values["AvgHops"] = buf;
+  values["Diameter"] = (metrics.diameter == U64_MAX)
+                           ? "inf"
+                           : std::to_string(metrics.diameter);
+  snprintf(buf, sizeof(buf), "%.3f", metrics.path_diversity);
+  values["PathDiversity"] = buf;
+  values["Populated"] = std::to_string(metrics.routers);
+  return values;
+}
+
+void GraphAnalytics::analyze(const std::deque<Hyperx>& _results) {
+  // measure the results in parallel
+  std::vector<Metrics> metrics(_results.size());
+  std::atomic<u64> next(0);
+  u64 threads = std::min<u64>(
+      _results.size(), std::max<u64>(1, std::thread::hardware_concurrency()));
+  std::vector<std::thread> workers;
+  for (u64 thread = 0; thread < threads; thread++) {
+    workers.emplace_back([this, &_results, &metrics, &next]() {
+      for (u64 idx = next++; idx < _results.size(); idx = next++) {
+        metrics.at(idx) = measure(_results.at(idx));
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  metrics_.clear();
+  for (u64 idx = 0; idx < _results.size(); idx++) {
+    metrics_[key(_results.at(idx))] = metrics.at(idx);
+  }
+}
+
+std::vector<u64> GraphAnalytics::key(const Hyperx& _hyperx) {
+  std::vector<u64> key = {_hyperx.concentration};
+  key.insert(key.end(), _hyperx.widths.begin(), _hyperx.widths.end());
+  key.insert(key.end(), _hyperx.weights.begin(), _hyperx.weights.end());
+  return key;
+}
+
+GraphAnalytics::Metrics GraphAnalytics::measure(const Hyperx& _hyperx) const {
+  // find the populated routers and the router id stride of each dimension
+  u64 dims = _hyperx.dimensions;
+  std::vector<u64> strides(dims);
+  u64 total = 1;
+  for (u64 dim = 0; dim < dims; dim++) {
+    strides.at(dim) = total;
+    total *= _hyperx.widths.at(dim);
+  }
+  u64 routers = std::max<u64>(
+      1, std::min<u64>(total, static_cast<u64>(std::ceil(populate_ * total))));
+
+  // the lines of each dimension, as the id of their first router
+  std::vector<std::vector<u64>> lines(dims);
+  for (u64 dim = 0; dim < dims; dim++) {
+    u64 width = _hyperx.widths.at(dim);
+    for (u64 id = 0; id < routers; id++) {
+      if (((id / strides.at(dim)) % width) == 0) {
+        lines.at(dim).push_back(id);
+      }
+    }
+  }
+
+  // bit-sliced counters are wide enough for the widest dimension
+  u64 slices = 1;
+  for (u64 width : _hyperx.widths) {
+    while ((1ul << slices) <= width) {
+      slices++;
+    }
+  }
+
+  u64 hops = 0;
+  u64 pairs = 0;
+  u64 unreachable = 0;
+  u64 diameter = 0;
+  u64 minimal_ports = 0;
+  std::vector<u64> visited(routers);
+  std::vector<u64> next(routers);
+  std::vector<std::vector<u64>> levels;
+  std::vector<u64> counter(slices);
+
+  for (u64 first = 0; first < routers; first += 64) {
+    // start a breadth first search from up to 64 sources
+    u64 sources = std::min<u64>(64, routers - first);
+    u64 all = (sources == 64) ? U64_MAX : ((1ul << sources) - 1);
+    levels.clear();
+    levels.emplace_back(routers, 0);
+    std::fill(visited.begin(), visited.end(), 0);
+    for (u64 src = 0; src < sources; src++) {
+      levels.at(0).at(first + src) = 1ul << src;
+      visited.at(first + src) = 1ul << src;
+    }
+
+    while (true) {
+      // everything adjacent to the last level via a dimension line
+      const std::vector<u64>& last = levels.back();
+      std::fill(next.begin(), next.end(), 0);
+      for (u64 dim = 0; dim < dims; dim++) {
+        u64 stride = strides.at(dim);
+        u64 width = _hyperx.widths.at(dim);
+        for (u64 line : lines.at(dim)) {
+          u64 reach = 0;
+          for (u64 c = 0, id = line; c < width && id < routers;
+               c++, id += stride) {
+            reach |= last[id];
+          }
+          for (u64 c = 0, id = line; c < width && id < routers;
+               c++, id += stride) {
+            next[id] |= reach;
+          }
+        }
+      }
+      bool found = false;
+      for (u64 id = 0; id < routers; id++) {
+        next[id] &= ~visited[id];
+        visited[id] |= next[id];
+        found |= (next[id] != 0);
+      }
+      if (!found) {
+        break;
+      }
+      levels.push_back(next);
+    }
+
+    // accumulate hops and the diameter
+    for (u64 level = 1; level < levels.size(); level++) {
+      u64 count = 0;
+      for (u64 id = 0; id < routers; id++) {
+        count += __builtin_popcountl(levels.at(level)[id]);
+      }
+      hops += level * count;
+      pairs += count;
+      diameter = std::max(diameter, (count > 0) ? level : 0);
+    }
+    for (u64 id = 0; id < routers; id++) {
+      unreachable += __builtin_popcountl(~visited[id] & all);
+    }
+
+    // count the channels from each router towards the sources it reaches in
+    //  'level' hops that lead to routers reaching them in 'level - 1' hops
+    for (u64 level = 1; level < levels.size(); level++) {
+      const std::vector<u64>& here = levels.at(level);
+      const std::vector<u64>& closer = levels.at(level - 1);
+      for (u64 dim = 0; dim < dims; dim++) {
+        u64 stride = strides.at(dim);
+        u64 width = _hyperx.widths.at(dim);
+        u64 weight = _hyperx.weights.at(dim);
+        for (u64 line : lines.at(dim)) {
+          // per source bit counts of the line's routers in the closer level
+          std::fill(counter.begin(), counter.end(), 0);
+          for (u64 c = 0, id = line; c < width && id < routers;
+               c++, id += stride) {
+            u64 carry = closer[id];
+            for (u64 s = 0; s < slices && carry != 0; s++) {
+              u64 sum = counter[s] ^ carry;
+              carry &= counter[s];
+              counter[s] = sum;
+            }
+          }
+          for (u64 c = 0, id = line; c < width && id < routers;
+               c++, id += stride) {
+            u64 mask = here[id];
+            if (mask == 0) {
+              continue;
+            }
+            u64 ports = 0;
+            for (u64 s = 0; s < slices; s++) {
+              ports += static_cast<u64>(__builtin_popcountl(mask & counter[s]))
+                       << s;
+            }
+            minimal_ports += ports * weight;
+          }
+        }
+      }
+    }
+  }
+
+  Metrics metrics;
+  metrics.routers = routers;
+  metrics.average_hops = (pairs == 0) ? 0.0 : static_cast<f64>(hops) / pairs;
+  metrics.diameter = (unreachable > 0) ? U64_MAX : diameter;
+  metrics.path_diversity =
+      (pairs == 0) ? 0.0 : static_cast<f64>(minimal_ports) / pairs;
+  return metrics;
+}
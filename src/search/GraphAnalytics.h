@@ -0,0 +1,84 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_GRAPHANALYTICS_H_
+#define SEARCH_GRAPHANALYTICS_H_
+
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/RouterChannelCount.h"
+
+// Costs like RouterChannelCount and reports measured properties of the router
+//  graph: the average minimal hop count between distinct routers (i.e.,
+//  uniform traffic), the diameter, and the minimal path diversity (the average
+//  number of channels leaving the source router on a minimal path).
+//
+// The graph may be partially populated with the 'populate' setting, a
+//  fraction of the routers kept in router id order (dimension 0 fastest),
+//  where the closed forms no longer apply.
+//
+// The metrics come from breadth first searches run from 64 sources at once,
+//  one bit per source. HyperX dimensions are cliques, so a level expands
+//  through the OR of each dimension line and the path diversity counts come
+//  from bit-sliced counters of each line.
+class GraphAnalytics : public RouterChannelCount {
+ public:
+  explicit GraphAnalytics(
+      const std::unordered_map<std::string, std::string>& _settings);
+  ~GraphAnalytics();
+
+  const std::vector<std::string>& extFields() const override;
+  std::unordered_map<std::string, std::string> extValues(
+      const Hyperx& _hyperx) const override;
+  void analyze(const std::deque<Hyperx>& _results) override;
+
+ private:
+  struct Metrics {
+    u64 routers;
+    f64 average_hops;
+    u64 diameter;  // U64_MAX when disconnected
+    f64 path_diversity;
+  };
+
+  static std::vector<u64> key(const Hyperx& _hyperx);
+  Metrics measure(const Hyperx& _hyperx) const;
+
+  f64 populate_;
+  std::vector<std::string> fields_;
+  std::map<std::vector<u64>, Metrics> metrics_;
+};
+
+#endif  // SEARCH_GRAPHANALYTICS_H_
@@ -0,0 +1,274 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Netlist.h"
+
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "strop/strop.h"
+
+static const char kMagic[8] = {'H', 'X', 'N', 'E', 'T', 'L', 'S', '1'};
+
+// the size of each thread's output buffer
+static const u64 kBlockSize = 1 << 20;
+
+// the largest record is a router channel line of 5 numbers
+static const u64 kMaxRecord = 2 + 5 * 21;
+
+class Netlist::Block {
+ public:
+  Block(Netlist* _netlist, Format _format)
+      : netlist_(_netlist), format_(_format), size_(0), channels_(0) {}
+
+  void terminal(u64 _terminal, u64 _router, u64 _port) {
+    if (format_ == Format::kText) {
+      text('t');
+      number(_terminal);
+      number(_router);
+      number(_port);
+      data_[size_ - 1] = '\n';
+    } else {
+      record(_terminal, U32_MAX, _router, _port);
+    }
+    channels_++;
+  }
+
+  void channel(u64 _dim, u64 _router_a, u64 _port_a, u64 _router_b,
+               u64 _port_b) {
+    if (format_ == Format::kText) {
+      text('r');
+      number(_dim);
+      number(_router_a);
+      number(_port_a);
+      number(_router_b);
+      number(_port_b);
+      data_[size_ - 1] = '\n';
+    } else {
+      record(_router_a, _port_a, _router_b, _port_b);
+    }
+    channels_++;
+  }
+
+  void flush() {
+    netlist_->output(data_, size_);
+    size_ = 0;
+  }
+
+  u64 channels() const {
+    return channels_;
+  }
+
+ private:
+  void text(char _type) {
+    if (size_ + kMaxRecord > kBlockSize) {
+      flush();
+    }
+    data_[size_++] = _type;
+    data_[size_++] = ' ';
+  }
+
+  void number(u64 _value) {
+    char* end = std::to_chars(data_ + size_, data_ + kBlockSize, _value).ptr;
+    *end = ' ';
+    size_ = (end - data_) + 1;
+  }
+
+  void record(u64 _a, u64 _b, u64 _c, u64 _d) {
+    if (size_ + 4 * sizeof(u32) > kBlockSize) {
+      flush();
+    }
+    u32 values[4] = {static_cast<u32>(_a), static_cast<u32>(_b),
+                     static_cast<u32>(_c), static_cast<u32>(_d)};
+    memcpy(data_ + size_, values, sizeof(values));
+    size_ += sizeof(values);
+  }
+
+  Netlist* netlist_;
+  Format format_;
+  u64 size_;
+  u64 channels_;
+  char data_[kBlockSize];
+};
+
+Netlist::Netlist(const Hyperx& _hyperx, Format _format)
+    : hyperx_(_hyperx), format_(_format), file_(nullptr) {
+  if ((hyperx_.widths.size() != hyperx_.dimensions) ||
+      (hyperx_.weights.size() != hyperx_.dimensions) ||
+      (hyperx_.dimensions == 0)) {
+    throw std::runtime_error("widths and weights must match dimensions");
+  }
+  if (hyperx_.concentration == 0) {
+    throw std::runtime_error("concentration must be greater than 0");
+  }
+
+  // compute the router numbering and the port layout
+  hyperx_.routers = 1;
+  u64 ports = hyperx_.concentration;
+  for (u64 dim = 0; dim < hyperx_.dimensions; dim++) {
+    if (hyperx_.widths.at(dim) < 2) {
+      throw std::runtime_error("widths must be greater than 1");
+    }
+    if (hyperx_.weights.at(dim) < 1) {
+      throw std::runtime_error("weights must be greater than 0");
+    }
+    strides_.push_back(hyperx_.routers);
+    port_bases_.push_back(ports);
+    if (__builtin_mul_overflow(hyperx_.routers, hyperx_.widths.at(dim),
+                               &hyperx_.routers)) {
+      throw std::runtime_error("too many routers");
+    }
+    ports += (hyperx_.widths.at(dim) - 1) * hyperx_.weights.at(dim);
+  }
+  if (__builtin_mul_overflow(hyperx_.routers, hyperx_.concentration,
+                             &hyperx_.terminals)) {
+    throw std::runtime_error("too many terminals");
+  }
+  hyperx_.router_radix = ports;
+  hyperx_.channels = Engine::channelCount(hyperx_);
+
+  if ((format_ == Format::kBinary) &&
+      ((hyperx_.terminals >= U32_MAX) || (hyperx_.router_radix >= U32_MAX))) {
+    throw std::runtime_error("the binary format is limited to 32-bit values");
+  }
+}
+
+Netlist::~Netlist() {}
+
+u64 Netlist::write(FILE* _file) {
+  file_ = _file;
+
+  // write the header
+  if (format_ == Format::kText) {
+    std::string header =
+        "# hyperx S=" + strop::vecString<u64>(hyperx_.widths) +
+        " K=" + strop::vecString<u64>(hyperx_.weights) +
+        " T=" + std::to_string(hyperx_.concentration) +
+        " routers=" + std::to_string(hyperx_.routers) +
+        " terminals=" + std::to_string(hyperx_.terminals) +
+        " radix=" + std::to_string(hyperx_.router_radix) +
+        " channels=" + std::to_string(hyperx_.channels) + "\n";
+    output(header.data(), header.size());
+  } else {
+    std::vector<u32> header = {static_cast<u32>(hyperx_.dimensions),
+                               static_cast<u32>(hyperx_.concentration)};
+    for (u64 width : hyperx_.widths) {
+      header.push_back(static_cast<u32>(width));
+    }
+    for (u64 weight : hyperx_.weights) {
+      header.push_back(static_cast<u32>(weight));
+    }
+    output(kMagic, sizeof(kMagic));
+    output(reinterpret_cast<const char*>(header.data()),
+           header.size() * sizeof(u32));
+    output(reinterpret_cast<const char*>(&hyperx_.channels),
+           sizeof(hyperx_.channels));
+  }
+
+  // generate the terminal channels and each dimension in parallel
+  std::vector<u64> channels(1 + hyperx_.dimensions, 0);
+  std::vector<std::exception_ptr> errors(1 + hyperx_.dimensions);
+  std::vector<std::thread> threads;
+  for (u64 section = 0; section <= hyperx_.dimensions; section++) {
+    threads.emplace_back([this, section, &channels, &errors]() {
+      try {
+        std::unique_ptr<Block> block(new Block(this, format_));
+        if (section == 0) {
+          terminals(block.get());
+        } else {
+          dimension(section - 1, block.get());
+        }
+        block->flush();
+        channels.at(section) = block->channels();
+      } catch (...) {
+        errors.at(section) = std::current_exception();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  if (fflush(file_) != 0) {
+    throw std::runtime_error("unable to write the netlist");
+  }
+
+  u64 total = 0;
+  for (u64 count : channels) {
+    total += count;
+  }
+  return total;
+}
+
+void Netlist::terminals(Block* _block) const {
+  u64 terminal = 0;
+  for (u64 router = 0; router < hyperx_.routers; router++) {
+    for (u64 port = 0; port < hyperx_.concentration; port++) {
+      _block->terminal(terminal++, router, port);
+    }
+  }
+}
+
+void Netlist::dimension(u64 _dim, Block* _block) const {
+  u64 width = hyperx_.widths.at(_dim);
+  u64 weight = hyperx_.weights.at(_dim);
+  u64 stride = strides_.at(_dim);
+  u64 base = port_bases_.at(_dim);
+
+  // each router connects to its peers with a larger coordinate in this
+  //  dimension. a router's ports to its peers skip its own coordinate.
+  for (u64 router = 0; router < hyperx_.routers; router++) {
+    u64 coord = (router / stride) % width;
+    for (u64 peer = coord + 1; peer < width; peer++) {
+      u64 other = router + (peer - coord) * stride;
+      u64 port = base + (peer - 1) * weight;
+      u64 other_port = base + coord * weight;
+      for (u64 copy = 0; copy < weight; copy++) {
+        _block->channel(_dim, router, port + copy, other, other_port + copy);
+      }
+    }
+  }
+}
+
+void Netlist::output(const char* _data, u64 _size) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (fwrite(_data, 1, _size, file_) != _size) {
+    throw std::runtime_error("unable to write the netlist");
+  }
+}
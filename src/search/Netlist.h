@@ -0,0 +1,86 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_NETLIST_H_
+#define SEARCH_NETLIST_H_
+
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+
+// Streams every channel of a HyperX. Routers are numbered by their coordinate
+//  with dimension 0 varying fastest and terminal t attaches to port t % T of
+//  router t / T, the same scheme as scripts/hyperx_coordinate.py. Router ports
+//  are the T terminal ports followed by each dimension's ports, a dimension
+//  with width S and weight K having K ports to each of its S-1 peers.
+//
+// The text format is a '#' header line followed by one line per channel:
+//  t <terminal> <router> <port>
+//  r <dimension> <router> <port> <router> <port>
+//
+// The binary format is the magic "HXNETLS1", u32 dimensions, u32
+//  concentration, u32 widths[dimensions], u32 weights[dimensions], u64
+//  channels, then one record of 4 u32s per channel. Terminal channels are
+//  {terminal, U32_MAX, router, port} and router channels are {router, port,
+//  router, port}. All values are little-endian.
+//
+// Each dimension is generated by its own thread into a fixed size block that
+//  is written to the output when full, so blocks of different dimensions are
+//  interleaved in the output.
+class Netlist {
+ public:
+  enum class Format { kText, kBinary };
+
+  Netlist(const Hyperx& _hyperx, Format _format);
+  ~Netlist();
+
+  // writes the complete netlist and returns the number of channels written
+  u64 write(FILE* _file);
+
+ private:
+  class Block;
+
+  void terminals(Block* _block) const;
+  void dimension(u64 _dim, Block* _block) const;
+  void output(const char* _data, u64 _size);
+
+  Hyperx hyperx_;
+  Format format_;
+  std::vector<u64> strides_;
+  std::vector<u64> port_bases_;
+
+  FILE* file_;
+  std::mutex lock_;
+};
+
+#endif  // SEARCH_NETLIST_H_
@@ -0,0 +1,261 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Packaging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+Packaging::Packaging(
+    const std::unordered_map<std::string, std::string>& _settings)
+    : router_price_(0.0), rack_price_(0.0), routers_per_rack_(0),
+      racks_per_row_(0), rack_pitch_(0.0), row_pitch_(0.0), intra_rack_(0.0),
+      terminal_length_(-1.0) {
+  std::string catalog;
+  for (const auto& setting : _settings) {
+    if (setting.first == "catalog") {
+      catalog = setting.second;
+    } else {
+      throw std::runtime_error("unknown packaging setting: " + setting.first);
+    }
+  }
+  if (catalog.empty()) {
+    throw std::runtime_error("packaging needs a catalog file");
+  }
+  load(catalog);
+
+  // tabulate the cable between racks up to the rows any cable can span
+  f64 longest = cables_.back().length;
+  table_rows_ = 1;
+  while ((intra_rack_ + table_rows_ * row_pitch_) <= longest) {
+    table_rows_++;
+  }
+  table_.resize(table_rows_ * racks_per_row_);
+  for (u64 row = 0; row < table_rows_; row++) {
+    for (u64 col = 0; col < racks_per_row_; col++) {
+      table_.at(row * racks_per_row_ + col) = static_cast<s32>(
+          cheapest(intra_rack_ + row * row_pitch_ + col * rack_pitch_));
+    }
+  }
+  terminal_cable_ = static_cast<s32>(cheapest(terminal_length_));
+  if (terminal_cable_ < 0) {
+    throw std::runtime_error("no catalog cable fits a terminal");
+  }
+
+  fields_ = {"Racks", "CablePrice"};
+  for (const Cable& cable : cables_) {
+    fields_.push_back(cable.name);
+  }
+}
+
+Packaging::~Packaging() {}
+
+f64 Packaging::cost(const Hyperx& _hyperx) const {
+  f64 cable_price = cables(_hyperx, [](u64, f64) {});
+  u64 racks = (_hyperx.routers + routers_per_rack_ - 1) / routers_per_rack_;
+  return _hyperx.routers * router_price_ + racks * rack_price_ + cable_price;
+}
+
+const std::vector<std::string>& Packaging::extFields() const {
+  return fields_;
+}
+
+std::unordered_map<std::string, std::string> Packaging::extValues(
+    const Hyperx& _hyperx) const {
+  std::vector<f64> counts(cables_.size(), 0.0);
+  f64 cable_price = cables(_hyperx, [&counts](u64 _cable, f64 _count) {
+    counts.at(_cable) += _count;
+  });
+
+  char buf[32];
+  std::unordered_map<std::string, std::string> values;
+  values["Racks"] = std::to_string(
+      (_hyperx.routers + routers_per_rack_ - 1) / routers_per_rack_);
+  snprintf(buf, sizeof(buf), "%.2f", cable_price);
+  values["CablePrice"] = buf;
+  for (u64 idx = 0; idx < cables_.size(); idx++) {
+    snprintf(buf, sizeof(buf), "%.0f", counts.at(idx));
+    values[cables_.at(idx).name] = buf;
+  }
+  return values;
+}
+
+void Packaging::load(const std::string& _filename) {
+  std::ifstream file(_filename);
+  if (!file) {
+    throw std::runtime_error("unable to open catalog " + _filename);
+  }
+  std::string line;
+  for (u64 number = 1; std::getline(file, line); number++) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream tokens(line);
+    std::string key;
+    if (!(tokens >> key)) {
+      continue;
+    }
+    bool ok;
+    if (key == "cable") {
+      Cable cable;
+      ok = static_cast<bool>(tokens >> cable.name >> cable.length >>
+                             cable.price) &&
+           (cable.length > 0.0) && (cable.price >= 0.0);
+      cables_.push_back(cable);
+    } else if (key == "router_price") {
+      ok = static_cast<bool>(tokens >> router_price_);
+    } else if (key == "rack_price") {
+      ok = static_cast<bool>(tokens >> rack_price_);
+    } else if (key == "routers_per_rack") {
+      ok = static_cast<bool>(tokens >> routers_per_rack_);
+    } else if (key == "racks_per_row") {
+      ok = static_cast<bool>(tokens >> racks_per_row_);
+    } else if (key == "rack_pitch") {
+      ok = static_cast<bool>(tokens >> rack_pitch_);
+    } else if (key == "row_pitch") {
+      ok = static_cast<bool>(tokens >> row_pitch_);
+    } else if (key == "intra_rack") {
+      ok = static_cast<bool>(tokens >> intra_rack_);
+    } else if (key == "terminal_length") {
+      ok = static_cast<bool>(tokens >> terminal_length_);
+    } else {
+      ok = false;
+    }
+    std::string extra;
+    if (!ok || (tokens >> extra)) {
+      throw std::runtime_error(_filename + ":" + std::to_string(number) +
+                               ": invalid catalog entry");
+    }
+  }
+
+  if (cables_.empty()) {
+    throw std::runtime_error("the catalog has no cables");
+  }
+  if ((routers_per_rack_ == 0) || (racks_per_row_ == 0)) {
+    throw std::runtime_error(
+        "routers_per_rack and racks_per_row must be greater than 0");
+  }
+  if ((rack_pitch_ <= 0.0) || (row_pitch_ <= 0.0) || (intra_rack_ < 0.0)) {
+    throw std::runtime_error(
+        "rack_pitch and row_pitch must be positive, intra_rack not negative");
+  }
+  if (terminal_length_ < 0.0) {
+    terminal_length_ = intra_rack_;
+  }
+  std::sort(cables_.begin(), cables_.end(),
+            [](const Cable& _a, const Cable& _b) {
+              return _a.length < _b.length;
+            });
+}
+
+s64 Packaging::cheapest(f64 _length) const {
+  s64 best = -1;
+  for (u64 idx = 0; idx < cables_.size(); idx++) {
+    if ((cables_.at(idx).length >= _length) &&
+        ((best < 0) || (cables_.at(idx).price < cables_.at(best).price))) {
+      best = static_cast<s64>(idx);
+    }
+  }
+  return best;
+}
+
+template <typename Visit>
+f64 Packaging::cables(const Hyperx& _hyperx, Visit _visit) const {
+  const u64 racks_per_row = racks_per_row_;
+  u64 total_racks = (_hyperx.routers + routers_per_rack_ - 1) /
+                    routers_per_rack_;
+  f64 price = 0.0;
+
+  // terminal cables stay within the rack
+  price += _hyperx.terminals * cables_[terminal_cable_].price;
+  _visit(terminal_cable_, static_cast<f64>(_hyperx.terminals));
+
+  u64 stride = 1;
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    u64 width = _hyperx.widths[dim];
+    f64 lines = static_cast<f64>(_hyperx.routers / width);
+    f64 weight = static_cast<f64>(_hyperx.weights[dim]);
+    bool within_rack = (routers_per_rack_ % (stride * width)) == 0;
+
+    for (u64 j = 1; j < width; j++) {
+      // the channels between routers 'j' apart in this dimension
+      f64 channels = (width - j) * lines * weight;
+      u64 distance = j * stride;
+      u64 racks[2] = {distance / routers_per_rack_,
+                      distance / routers_per_rack_ + 1};
+      f64 chances[2] = {1.0, 0.0};
+      if (within_rack) {
+        racks[0] = 0;
+      } else {
+        u64 offset = distance % routers_per_rack_;
+        chances[0] = static_cast<f64>(routers_per_rack_ - offset) /
+                     routers_per_rack_;
+        chances[1] = static_cast<f64>(offset) / routers_per_rack_;
+      }
+
+      for (u64 r = 0; r < 2; r++) {
+        if (chances[r] == 0.0) {
+          continue;
+        }
+        // racks 'apart' racks apart are 'col' columns apart unless the
+        //  row wraps between them, counted over the first racks of the pairs
+        u64 apart = racks[r];
+        u64 col = apart % racks_per_row;
+        u64 row = apart / racks_per_row;
+        u64 firsts = std::max<u64>(1, total_racks - std::min(total_racks,
+                                                             apart));
+        u64 wraps = (firsts / racks_per_row) * col +
+                    (firsts % racks_per_row) -
+                    std::min(firsts % racks_per_row, racks_per_row - col);
+        u64 rows[2] = {row, row + 1};
+        u64 cols[2] = {col, racks_per_row - col};
+        f64 spans[2] = {static_cast<f64>(firsts - wraps) / firsts,
+                        static_cast<f64>(wraps) / firsts};
+        for (u64 s = 0; s < 2; s++) {
+          if (spans[s] == 0.0) {
+            continue;
+          }
+          s32 cable = (rows[s] < table_rows_) ?
+                      table_[rows[s] * racks_per_row + cols[s]] : -1;
+          if (cable < 0) {
+            return F64_POS_INF;
+          }
+          f64 count = channels * chances[r] * spans[s];
+          price += count * cables_[cable].price;
+          _visit(cable, count);
+        }
+      }
+    }
+    stride *= width;
+  }
+  return price;
+}
@@ -0,0 +1,114 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_PACKAGING_H_
+#define SEARCH_PACKAGING_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Calculator.h"
+#include "search/Engine.h"
+
+// Costs a HyperX by its parts once packaged into racks. Routers fill racks in
+//  router id order (dimension 0 fastest) and racks fill rows. A cable within
+//  a rack is 'intra_rack' long, otherwise it also runs the rack and row
+//  distance between its ends. Each cable is the cheapest catalog cable that
+//  is long enough.
+//
+// The catalog file has one entry per line, '#' starts a comment:
+//  router_price <price>
+//  rack_price <price>
+//  routers_per_rack <count>
+//  racks_per_row <count>
+//  rack_pitch <meters>       between adjacent racks of a row
+//  row_pitch <meters>        between adjacent rows
+//  intra_rack <meters>       cable length within a rack
+//  terminal_length <meters>  terminal cable length (intra_rack)
+//  cable <name> <meters> <price>
+//
+// All pairs of routers in a dimension that are 'j' apart in the dimension
+//  are 'j' times its stride apart in router id. The chance such a pair spans
+//  racks, and how the racks lie in rows, follows from the router's position
+//  within its rack, taken as uniform unless whole lines of the dimension fit
+//  in a rack. The price per dimension is thus a sum over its widths with a
+//  few table lookups each.
+class Packaging : public Calculator {
+ public:
+  explicit Packaging(
+      const std::unordered_map<std::string, std::string>& _settings);
+  ~Packaging();
+
+  f64 cost(const Hyperx& _hyperx) const override;
+  const std::vector<std::string>& extFields() const override;
+  std::unordered_map<std::string, std::string> extValues(
+      const Hyperx& _hyperx) const override;
+
+ private:
+  struct Cable {
+    std::string name;
+    f64 length;
+    f64 price;
+  };
+
+  void load(const std::string& _filename);
+  // the cheapest cable at least '_length' long, or -1 if none is
+  s64 cheapest(f64 _length) const;
+  // calls '_visit(cable, count)' with the expected cable counts of each
+  //  dimension, returns the total price
+  template <typename Visit>
+  f64 cables(const Hyperx& _hyperx, Visit _visit) const;
+
+  f64 router_price_;
+  f64 rack_price_;
+  u64 routers_per_rack_;
+  u64 racks_per_row_;
+  f64 rack_pitch_;
+  f64 row_pitch_;
+  f64 intra_rack_;
+  f64 terminal_length_;
+  std::vector<Cable> cables_;  // by length
+
+  // the cable between racks some rows and columns apart, row-major with
+  //  'racks_per_row_' columns. -1 is too long for any cable.
+  std::vector<s32> table_;
+  u64 table_rows_;
+  s32 terminal_cable_;
+  std::vector<std::string> fields_;
+};
+
+template <>
+struct CostTraits<Packaging> {
+  static constexpr bool kReadsBisections = false;
+};
+
+#endif  // SEARCH_PACKAGING_H_
@@ -0,0 +1,630 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Resilience.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "strop/strop.h"
+
+namespace {
+
+// a union-find over routers tracking the largest component
+class Components {
+ public:
+  explicit Components(u64 _routers)
+      : parent_(_routers), size_(_routers, 1), largest_(1) {
+    std::iota(parent_.begin(), parent_.end(), 0);
+  }
+
+  u64 find(u64 _router) {
+    while (parent_[_router] != _router) {
+      parent_[_router] = parent_[parent_[_router]];
+      _router = parent_[_router];
+    }
+    return _router;
+  }
+
+  void merge(u64 _a, u64 _b) {
+    _a = find(_a);
+    _b = find(_b);
+    if (_a != _b) {
+      if (size_[_a] < size_[_b]) {
+        std::swap(_a, _b);
+      }
+      parent_[_b] = _a;
+      size_[_a] += size_[_b];
+      largest_ = std::max(largest_, size_[_a]);
+    }
+  }
+
+  u64 largest() const {
+    return largest_;
+  }
+
+ private:
+  std::vector<u64> parent_;
+  std::vector<u64> size_;
+  u64 largest_;
+};
+
+// the random stream of a trial, splitmix64 seeded by hashing the values that
+//  identify the trial. it is far cheaper to start than std::mt19937_64 with
+//  a std::seed_seq, which dominated short trials.
+class TrialRandom {
+ public:
+  typedef u64 result_type;
+
+  explicit TrialRandom(const std::vector<u64>& _values) : state_(0) {
+    for (u64 value : _values) {
+      state_ = mix(state_ + kGamma + value);
+    }
+  }
+
+  static constexpr u64 min() {
+    return 0;
+  }
+
+  static constexpr u64 max() {
+    return U64_MAX;
+  }
+
+  u64 operator()() {
+    state_ += kGamma;
+    return mix(state_);
+  }
+
+ private:
+  static constexpr u64 kGamma = 0x9E3779B97F4A7C15ull;
+
+  static u64 mix(u64 _z) {
+    _z = (_z ^ (_z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    _z = (_z ^ (_z >> 27)) * 0x94D049BB133111EBull;
+    return _z ^ (_z >> 31);
+  }
+
+  u64 state_;
+};
+
+// a pool of one thread less than the hardware threads shared by every
+//  caller. a caller runs its own tasks besides the pool, so callers that are
+//  already spread across threads (e.g., annealing chains) don't multiply the
+//  threads.
+class TrialPool {
+ public:
+  static TrialPool& instance() {
+    static TrialPool pool;
+    return pool;
+  }
+
+  void run(u64 _tasks, const std::function<void(u64)>& _task) {
+    Job job = {&_task, _tasks, 0, _tasks, {}};
+    std::unique_lock<std::mutex> lock(lock_);
+    jobs_.push_back(&job);
+    wake_.notify_all();
+    while (job.next < job.tasks) {
+      work(&job, &lock);
+    }
+    job.finished.wait(lock, [&job]() { return job.pending == 0; });
+  }
+
+ private:
+  struct Job {
+    const std::function<void(u64)>* task;
+    u64 tasks;
+    u64 next;
+    u64 pending;
+    std::condition_variable finished;
+  };
+
+  TrialPool() : stop_(false) {
+    u64 threads = std::max<u64>(1, std::thread::hardware_concurrency());
+    for (u64 thread = 1; thread < threads; thread++) {
+      workers_.emplace_back([this]() {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true) {
+          wake_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+          if (stop_) {
+            return;
+          }
+          work(jobs_.front(), &lock);
+        }
+      });
+    }
+  }
+
+  ~TrialPool() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // runs the next task of a job that has tasks left, the job is removed from
+  //  the queue once all its tasks are taken
+  void work(Job* _job, std::unique_lock<std::mutex>* _lock) {
+    u64 task = _job->next++;
+    if (_job->next == _job->tasks) {
+      jobs_.erase(std::find(jobs_.begin(), jobs_.end(), _job));
+    }
+    _lock->unlock();
+    (*_job->task)(task);
+    _lock->lock();
+    if (--_job->pending == 0) {
+      _job->finished.notify_all();
+    }
+  }
+
+  std::mutex lock_;
+  std::condition_variable wake_;
+  std::deque<Job*> jobs_;
+  std::vector<std::thread> workers_;
+  bool stop_;
+};
+
+// a failed router pair, all of whose channels failed below 'threshold'
+struct DeadPair {
+  u64 pair;
+  f64 threshold;
+};
+
+}  // namespace
+
+Resilience::Resilience(
+    const std::unordered_map<std::string, std::string>& _settings)
+    : trials_(1000), cost_trials_(100), seed_(12345678), penalty_(0.0) {
+  std::string rates = "0.01";
+  std::string percentiles = "50/99";
+  for (const auto& setting : _settings) {
+    if (setting.first == "rates") {
+      rates = setting.second;
+    } else if (setting.first == "trials") {
+      trials_ = std::stoull(setting.second);
+    } else if (setting.first == "costtrials") {
+      cost_trials_ = std::stoull(setting.second);
+    } else if (setting.first == "seed") {
+      seed_ = std::stoull(setting.second);
+    } else if (setting.first == "percentiles") {
+      percentiles = setting.second;
+    } else if (setting.first == "penalty") {
+      penalty_ = std::stod(setting.second);
+    } else {
+      throw std::runtime_error("unknown resilience setting: " +
+                               setting.first);
+    }
+  }
+
+  // sort the rates from highest to lowest
+  std::vector<std::pair<f64, std::string>> sorted;
+  for (const std::string& rate : strop::split(rates, '/')) {
+    sorted.emplace_back(std::stod(rate), rate);
+    if (!(sorted.back().first > 0.0) || !(sorted.back().first < 1.0)) {
+      throw std::runtime_error("failure rates must be in (0, 1)");
+    }
+  }
+  std::sort(sorted.rbegin(), sorted.rend());
+  for (const auto& rate : sorted) {
+    rates_.push_back(rate.first);
+    rate_names_.push_back(rate.second);
+  }
+  // sort the percentiles from lowest to highest, the last is the worst
+  sorted.clear();
+  for (const std::string& percentile : strop::split(percentiles, '/')) {
+    sorted.emplace_back(std::stod(percentile), percentile);
+    if (!(sorted.back().first >= 0.0) || (sorted.back().first > 100.0)) {
+      throw std::runtime_error("percentiles must be in [0, 100]");
+    }
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const std::pair<f64, std::string>& _a,
+                      const std::pair<f64, std::string>& _b) {
+                     return _a.first < _b.first;
+                   });
+  for (const auto& percentile : sorted) {
+    if (percentiles_.empty() || (percentile.first != percentiles_.back())) {
+      percentiles_.push_back(percentile.first);
+      percentile_names_.push_back(percentile.second);
+    }
+  }
+  if ((trials_ == 0) || (cost_trials_ == 0)) {
+    throw std::runtime_error("there must be at least one trial");
+  }
+  cost_trials_ = std::min(cost_trials_, trials_);
+  if (penalty_ < 0.0) {
+    throw std::runtime_error("penalty must not be negative");
+  }
+
+  for (const std::string& rate : rate_names_) {
+    for (const std::string& percentile : percentile_names_) {
+      fields_.push_back("Bisect@" + rate + "p" + percentile);
+      fields_.push_back("DimBisect@" + rate + "p" + percentile);
+      fields_.push_back("Disconn@" + rate + "p" + percentile);
+    }
+  }
+}
+
+Resilience::~Resilience() {}
+
+f64 Resilience::cost(const Hyperx& _hyperx) const {
+  f64 base = RouterChannelCount::cost(_hyperx);
+  if (penalty_ == 0.0) {
+    return base;
+  }
+
+  // the first entries are the highest rate, the last percentile is the worst
+  std::vector<f64> summary = measure(_hyperx, cost_trials_);
+  u64 worst = (percentiles_.size() - 1) * (2 + _hyperx.dimensions);
+  f64 original = *std::min_element(_hyperx.bisections.begin(),
+                                   _hyperx.bisections.end());
+  f64 lost = 1.0 - summary.at(worst) / original;
+  return base * (1.0 + penalty_ * (lost + summary.at(worst + 1)));
+}
+
+f64 Resilience::networkCost(const Network& _network) const {
+  if (penalty_ != 0.0) {
+    throw std::runtime_error("the resilience penalty only supports HyperX");
+  }
+  return RouterChannelCount::networkCost(_network);
+}
+
+const std::vector<std::string>& Resilience::extFields() const {
+  return fields_;
+}
+
+std::unordered_map<std::string, std::string> Resilience::extValues(
+    const Hyperx& _hyperx) const {
+  // use the summary of analyze() when available
+  std::vector<f64> summary;
+  auto it = summaries_.find(key(_hyperx));
+  if (it != summaries_.end()) {
+    summary = it->second;
+  } else {
+    summary = measure(_hyperx, trials_);
+  }
+
+  // each rate and percentile has the smallest bisection, the disconnected
+  //  fraction, and the bisection of each dimension
+  char buf[32];
+  std::unordered_map<std::string, std::string> values;
+  u64 stride = 2 + _hyperx.dimensions;
+  for (u64 idx = 0; idx < fields_.size() / 3; idx++) {
+    auto entry = summary.begin() + idx * stride;
+    snprintf(buf, sizeof(buf), "%.3f", entry[0]);
+    values[fields_.at(3 * idx)] = buf;
+    values[fields_.at(3 * idx + 1)] =
+        strop::vecString<f64>(std::vector<f64>(entry + 2, entry + stride),
+                              ',', 2);
+    snprintf(buf, sizeof(buf), "%.6f", entry[1]);
+    values[fields_.at(3 * idx + 2)] = buf;
+  }
+  return values;
+}
+
+void Resilience::analyze(const std::deque<Hyperx>& _results) {
+  // trials are spread across threads in chunks
+  u64 chunks = (trials_ + kChunk - 1) / kChunk;
+  std::vector<Graph> graphs;
+  std::vector<Samples> samples(_results.size());
+  for (u64 idx = 0; idx < _results.size(); idx++) {
+    graphs.push_back(build(_results.at(idx)));
+    samples.at(idx).resize(rates_.size(), trials_, _results.at(idx));
+  }
+
+  parallel(_results.size() * chunks, [&, this](u64 _task) {
+    u64 idx = _task / chunks;
+    u64 first = (_task % chunks) * kChunk;
+    u64 last = std::min(trials_, first + kChunk);
+    for (u64 trial = first; trial < last; trial++) {
+      simulate(_results.at(idx), graphs.at(idx), trial, &samples.at(idx));
+    }
+  });
+
+  summaries_.clear();
+  for (u64 idx = 0; idx < _results.size(); idx++) {
+    summaries_[key(_results.at(idx))] = summarize(&samples.at(idx));
+  }
+}
+
+std::vector<u64> Resilience::key(const Hyperx& _hyperx) {
+  std::vector<u64> key = {_hyperx.concentration};
+  key.insert(key.end(), _hyperx.widths.begin(), _hyperx.widths.end());
+  key.insert(key.end(), _hyperx.weights.begin(), _hyperx.weights.end());
+  return key;
+}
+
+Resilience::Graph Resilience::build(const Hyperx& _hyperx) {
+  Graph graph;
+  graph.routers = 1;
+  graph.channels = 0;
+  u64 pairs = 0;
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    u64 width = _hyperx.widths.at(dim);
+    u64 weight = _hyperx.weights.at(dim);
+    graph.strides.push_back(graph.routers);
+    graph.widths.push_back(width);
+    graph.weights.push_back(weight);
+    graph.routers *= width;
+  }
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    // router pairs of a line in (low, high) order
+    u64 width = graph.widths.at(dim);
+    u64 weight = graph.weights.at(dim);
+    graph.pairs.emplace_back();
+    for (u64 low = 0; low < width; low++) {
+      for (u64 high = low + 1; high < width; high++) {
+        graph.pairs.back().emplace_back(low, high);
+      }
+    }
+    u64 lines = graph.routers / width;
+    u64 half = width / 2;
+    graph.pair_offsets.push_back(pairs);
+    graph.channel_offsets.push_back(graph.channels);
+    graph.cut_channels.push_back(lines * half * (width - half) * weight);
+    pairs += lines * graph.pairs.back().size();
+    graph.channels += lines * graph.pairs.back().size() * weight;
+  }
+  graph.pair_offsets.push_back(pairs);
+  graph.channel_offsets.push_back(graph.channels);
+  return graph;
+}
+
+void Resilience::simulate(const Hyperx& _hyperx, const Graph& _graph,
+                          u64 _trial, Samples* _samples) const {
+  // each trial has its own random stream
+  std::vector<u64> seeds = key(_hyperx);
+  seeds.push_back(seed_);
+  seeds.push_back(_trial);
+  TrialRandom prng(seeds);
+
+  // the failed channels at the highest rate with their threshold, each
+  //  recorded as its dimension, router pair, and whether it is cut
+  u64 dims = _graph.widths.size();
+  f64 highest = rates_.front();
+  std::geometric_distribution<u64> gap(highest);
+  std::uniform_real_distribution<f64> threshold(0.0, highest);
+  std::vector<u64> failed_dims;
+  std::vector<u64> failed_pairs;
+  std::vector<bool> failed_cut;
+  std::vector<f64> failed_thresholds;
+  u64 dim = 0;
+  for (u64 channel = gap(prng); channel < _graph.channels;
+       channel += 1 + gap(prng)) {
+    while (channel >= _graph.channel_offsets.at(dim + 1)) {
+      dim++;
+    }
+    u64 local = (channel - _graph.channel_offsets.at(dim)) /
+                _graph.weights.at(dim);
+    u64 half = _graph.widths.at(dim) / 2;
+    const std::pair<u64, u64>& ends =
+        _graph.pairs.at(dim).at(local % _graph.pairs.at(dim).size());
+    failed_dims.push_back(dim);
+    failed_pairs.push_back(_graph.pair_offsets.at(dim) + local);
+    failed_cut.push_back((ends.first < half) && (ends.second >= half));
+    failed_thresholds.push_back(threshold(prng));
+  }
+
+  // router pairs are dead when all their channels failed, revived once the
+  //  rate falls to the highest threshold of their channels
+  std::vector<DeadPair> dead;
+  for (u64 first = 0, last = 0; first < failed_pairs.size(); first = last) {
+    f64 revive = 0.0;
+    for (last = first; (last < failed_pairs.size()) &&
+                       (failed_pairs.at(last) == failed_pairs.at(first));
+         last++) {
+      revive = std::max(revive, failed_thresholds.at(last));
+    }
+    if (last - first == _graph.weights.at(failed_dims.at(first))) {
+      dead.push_back({failed_pairs.at(first), revive});
+    }
+  }
+
+  // connect every line at the highest rate, a star from its first router
+  //  unless pairs of the line are dead
+  Components components(_graph.routers);
+  std::vector<u8> line_dead;
+  auto next_dead = dead.cbegin();
+  for (dim = 0; dim < dims; dim++) {
+    u64 width = _graph.widths.at(dim);
+    u64 stride = _graph.strides.at(dim);
+    u64 line_pairs = _graph.pairs.at(dim).size();
+    u64 lines = _graph.routers / width;
+    for (u64 line = 0; line < lines; line++) {
+      u64 base = _graph.pair_offsets.at(dim) + line * line_pairs;
+      u64 first = (line % stride) + (line / stride) * stride * width;
+      if ((next_dead == dead.cend()) ||
+          (next_dead->pair >= base + line_pairs)) {
+        for (u64 c = 1; c < width; c++) {
+          components.merge(first, first + c * stride);
+        }
+        continue;
+      }
+
+      line_dead.assign(line_pairs, 0);
+      for (; (next_dead != dead.cend()) &&
+             (next_dead->pair < base + line_pairs);
+           ++next_dead) {
+        line_dead.at(next_dead->pair - base) = 1;
+      }
+      // pair (0, c) is at index c - 1, routers cut off from the first router
+      //  join through any of their live pairs
+      for (u64 c = 1; c < width; c++) {
+        if (!line_dead.at(c - 1)) {
+          components.merge(first, first + c * stride);
+        }
+      }
+      for (u64 p = 0; p < line_pairs; p++) {
+        const std::pair<u64, u64>& ends = _graph.pairs.at(dim).at(p);
+        if (!line_dead.at(p) && (ends.first > 0) &&
+            (line_dead.at(ends.first - 1) || line_dead.at(ends.second - 1))) {
+          components.merge(first + ends.first * stride,
+                           first + ends.second * stride);
+        }
+      }
+    }
+  }
+
+  // walk the rates from highest to lowest reviving pairs and channels
+  std::sort(dead.begin(), dead.end(), [](const DeadPair& _a,
+                                         const DeadPair& _b) {
+    return _a.threshold > _b.threshold;
+  });
+  auto revived = dead.cbegin();
+  for (u64 rate = 0; rate < rates_.size(); rate++) {
+    for (; (revived != dead.cend()) && (revived->threshold >= rates_.at(rate));
+         ++revived) {
+      for (dim = 0; revived->pair >= _graph.pair_offsets.at(dim + 1); dim++) {}
+      u64 width = _graph.widths.at(dim);
+      u64 stride = _graph.strides.at(dim);
+      u64 local = revived->pair - _graph.pair_offsets.at(dim);
+      u64 line = local / _graph.pairs.at(dim).size();
+      const std::pair<u64, u64>& ends =
+          _graph.pairs.at(dim).at(local % _graph.pairs.at(dim).size());
+      u64 first = (line % stride) + (line / stride) * stride * width;
+      components.merge(first + ends.first * stride,
+                       first + ends.second * stride);
+    }
+
+    std::vector<u64> cut_failures(dims, 0);
+    for (u64 idx = 0; idx < failed_pairs.size(); idx++) {
+      if (failed_cut.at(idx) && (failed_thresholds.at(idx) < rates_.at(rate))) {
+        cut_failures.at(failed_dims.at(idx))++;
+      }
+    }
+    f64 bisection = INFINITY;
+    for (dim = 0; dim < dims; dim++) {
+      u64 cut = _graph.cut_channels.at(dim);
+      f64 surviving = _hyperx.bisections.at(dim) *
+                      (cut - cut_failures.at(dim)) / cut;
+      _samples->dimensions.at((rate * dims + dim) * _samples->trials +
+                              _trial) = surviving;
+      bisection = std::min(bisection, surviving);
+    }
+
+    u64 sample = rate * _samples->trials + _trial;
+    _samples->bisections.at(sample) = bisection;
+    _samples->disconnected.at(sample) =
+        1.0 - static_cast<f64>(components.largest()) / _graph.routers;
+  }
+}
+
+void Resilience::Samples::resize(u64 _rates, u64 _trials,
+                                 const Hyperx& _hyperx) {
+  trials = _trials;
+  bisections.resize(_rates * _trials);
+  disconnected.resize(_rates * _trials);
+  dimensions.resize(_rates * _hyperx.dimensions * _trials);
+}
+
+std::vector<f64> Resilience::summarize(Samples* _samples) const {
+  // percentiles rank trials from best to worst, each dimension on its own
+  u64 trials = _samples->trials;
+  u64 dims = _samples->dimensions.size() / (rates_.size() * trials);
+  auto sort = [trials](std::vector<f64>::iterator _first, bool _ascending) {
+    if (_ascending) {
+      std::sort(_first, _first + trials);
+    } else {
+      std::sort(_first, _first + trials, std::greater<f64>());
+    }
+  };
+  std::vector<f64> summary;
+  for (u64 rate = 0; rate < rates_.size(); rate++) {
+    auto bisections = _samples->bisections.begin() + rate * trials;
+    auto disconnected = _samples->disconnected.begin() + rate * trials;
+    auto dimensions = _samples->dimensions.begin() + rate * dims * trials;
+    sort(bisections, false);
+    sort(disconnected, true);
+    for (u64 dim = 0; dim < dims; dim++) {
+      sort(dimensions + dim * trials, false);
+    }
+    for (f64 percentile : percentiles_) {
+      u64 rank = static_cast<u64>(std::ceil(percentile / 100.0 * trials));
+      rank = std::min(trials - 1, (rank == 0) ? 0 : rank - 1);
+      summary.push_back(bisections[rank]);
+      summary.push_back(disconnected[rank]);
+      for (u64 dim = 0; dim < dims; dim++) {
+        summary.push_back(dimensions[dim * trials + rank]);
+      }
+    }
+  }
+  return summary;
+}
+
+std::vector<f64> Resilience::measure(const Hyperx& _hyperx,
+                                     u64 _trials) const {
+  // the graph of the last configuration is reused, the engine costs each
+  //  configuration once but extValues() may follow cost()
+  std::shared_ptr<const Graph> graph;
+  {
+    std::lock_guard<std::mutex> lock(graph_lock_);
+    if (!graph_ || (graph_key_ != key(_hyperx))) {
+      graph_ = std::make_shared<const Graph>(build(_hyperx));
+      graph_key_ = key(_hyperx);
+    }
+    graph = graph_;
+  }
+
+  Samples samples;
+  samples.resize(rates_.size(), _trials, _hyperx);
+  u64 chunks = (_trials + kChunk - 1) / kChunk;
+  parallel(chunks, [&, this](u64 _chunk) {
+    u64 last = std::min(_trials, (_chunk + 1) * kChunk);
+    for (u64 trial = _chunk * kChunk; trial < last; trial++) {
+      simulate(_hyperx, *graph, trial, &samples);
+    }
+  });
+  return summarize(&samples);
+}
+
+void Resilience::parallel(u64 _tasks,
+                          const std::function<void(u64)>& _task) const {
+  // a single task runs on the calling thread
+  if (_tasks <= 1) {
+    for (u64 task = 0; task < _tasks; task++) {
+      _task(task);
+    }
+    return;
+  }
+  TrialPool::instance().run(_tasks, _task);
+}
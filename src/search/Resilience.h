@@ -0,0 +1,146 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_RESILIENCE_H_
+#define SEARCH_RESILIENCE_H_
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/RouterChannelCount.h"
+
+// Costs like RouterChannelCount and reports how each result survives random
+//  link failures. Every trial fails each channel independently and measures
+//  the surviving bisection of each dimension (in the units of the Bisections
+//  column) and the fraction of terminals disconnected from the largest
+//  component. Percentiles rank the trials from best to worst, so 'p99' is a
+//  bad case. 'Bisect' is the smallest bisection over the dimensions and
+//  'DimBisect' lists the percentile of each dimension on its own.
+//
+// Settings:
+//  rates       '/' separated channel failure probabilities (0.01)
+//  trials      trials per result (1000)
+//  costtrials  trials of the penalty, the first of the result's trials (100)
+//  seed        random seed (12345678)
+//  percentiles '/' separated percentiles reported (50/99)
+//  penalty     when positive, the cost is scaled by
+//               1 + penalty * (lost bisection + disconnected terminals)
+//              at the highest rate and percentile (0)
+//
+// The penalty simulates every feasible configuration, on a thread pool
+//  shared by all callers, so 'costtrials' trades its accuracy for the search
+//  time. The penalty only applies to HyperX. The reported columns always use
+//  all the trials.
+//
+// Each trial has its own random stream seeded by the seed, the result, and
+//  the trial index, so results do not depend on the thread count. A trial
+//  draws the failures at the highest rate only, each with a threshold below
+//  that rate, and the lower rates keep the failures under their rate. The
+//  connectivity is built once at the highest rate with a union-find and the
+//  router pairs revived at each lower rate are merged into it.
+class Resilience : public RouterChannelCount {
+ public:
+  explicit Resilience(
+      const std::unordered_map<std::string, std::string>& _settings);
+  ~Resilience();
+
+  f64 cost(const Hyperx& _hyperx) const override;
+  f64 networkCost(const Network& _network) const override;
+  const std::vector<std::string>& extFields() const override;
+  std::unordered_map<std::string, std::string> extValues(
+      const Hyperx& _hyperx) const override;
+  void analyze(const std::deque<Hyperx>& _results) override;
+
+ private:
+  // the channels of a HyperX numbered dimension by dimension, line by line,
+  //  router pair by router pair
+  struct Graph {
+    u64 routers;
+    std::vector<u64> strides;
+    std::vector<u64> widths;
+    std::vector<u64> weights;
+    std::vector<u64> pair_offsets;
+    std::vector<u64> channel_offsets;
+    std::vector<u64> cut_channels;
+    std::vector<std::vector<std::pair<u64, u64>>> pairs;  // per dimension
+    u64 channels;
+  };
+
+  // per rate and trial, the surviving bisection and disconnected fraction,
+  //  and per rate, dimension, and trial, the bisection of the dimension
+  struct Samples {
+    u64 trials;
+    std::vector<f64> bisections;
+    std::vector<f64> disconnected;
+    std::vector<f64> dimensions;
+
+    void resize(u64 _rates, u64 _trials, const Hyperx& _hyperx);
+  };
+
+  // trials are spread across threads in chunks
+  static const u64 kChunk = 64;
+
+  static std::vector<u64> key(const Hyperx& _hyperx);
+  static Graph build(const Hyperx& _hyperx);
+  void simulate(const Hyperx& _hyperx, const Graph& _graph, u64 _trial,
+                Samples* _samples) const;
+  // per rate and percentile, the bisection, the disconnected fraction, and
+  //  the bisection of each dimension
+  std::vector<f64> summarize(Samples* _samples) const;
+  std::vector<f64> measure(const Hyperx& _hyperx, u64 _trials) const;
+  // runs tasks 0 to '_tasks' - 1 on the shared pool and the calling thread
+  void parallel(u64 _tasks, const std::function<void(u64)>& _task) const;
+
+  std::vector<f64> rates_;  // descending
+  std::vector<std::string> rate_names_;
+  std::vector<f64> percentiles_;
+  std::vector<std::string> percentile_names_;
+  u64 trials_;
+  u64 cost_trials_;
+  u64 seed_;
+  f64 penalty_;
+  std::vector<std::string> fields_;
+  std::map<std::vector<u64>, std::vector<f64>> summaries_;
+
+  mutable std::mutex graph_lock_;
+  mutable std::vector<u64> graph_key_;
+  mutable std::shared_ptr<const Graph> graph_;
+};
+
+#endif  // SEARCH_RESILIENCE_H_
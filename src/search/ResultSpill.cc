@@ -0,0 +1,289 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/ResultSpill.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <stdexcept>
+
+#include "search/Engine.h"
+
+// record layout: f64 cost, u32 concentration, u16 widths[], u16 weights[]
+static const u64 kCostOffset = 0;
+static const u64 kConcentrationOffset = 8;
+static const u64 kWidthsOffset = 12;
+
+ResultSpill::ResultSpill(u64 _max_results, u64 _max_dimensions,
+                         u64 _memory_limit, const std::string& _directory)
+    : max_results_(_max_results), max_dimensions_(_max_dimensions),
+      record_size_((kWidthsOffset + 4 * _max_dimensions + 7) / 8 * 8),
+      directory_(_directory), count_(0), threshold_(F64_POS_INF),
+      spilled_(0) {
+  capacity_ = _memory_limit / (record_size_ + sizeof(u32));
+  capacity_ = std::min<u64>(capacity_, U32_MAX);
+  if (capacity_ < 2) {
+    throw std::runtime_error("the spill memory limit is too small");
+  }
+}
+
+ResultSpill::~ResultSpill() {
+  clear();
+}
+
+void ResultSpill::clear() {
+  for (Run& run : runs_) {
+    fclose(run.file);
+  }
+  runs_.clear();
+  count_ = 0;
+  threshold_ = F64_POS_INF;
+  spilled_ = 0;
+}
+
+f64 ResultSpill::threshold() const {
+  return threshold_;
+}
+
+void ResultSpill::add(const Hyperx& _hyperx) {
+  if ((max_results_ == 0) || (_hyperx.cost > threshold_)) {
+    return;
+  }
+  if (_hyperx.dimensions > max_dimensions_) {
+    throw std::runtime_error("too many dimensions to spill");
+  }
+  if (count_ == capacity_) {
+    spill();
+  }
+  if (block_.size() == count_ * record_size_) {
+    // the block grows up to the memory limit
+    u64 records = std::min(capacity_, std::max<u64>(1024, 2 * count_));
+    block_.resize(records * record_size_);
+  }
+
+  u8* record = &block_[count_ * record_size_];
+  memset(record, 0, record_size_);
+  memcpy(record + kCostOffset, &_hyperx.cost, sizeof(f64));
+  if (_hyperx.concentration > U32_MAX) {
+    throw std::runtime_error("the concentration is too large to spill");
+  }
+  u32 concentration = static_cast<u32>(_hyperx.concentration);
+  memcpy(record + kConcentrationOffset, &concentration, sizeof(u32));
+  u16* values = reinterpret_cast<u16*>(record + kWidthsOffset);
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    if ((_hyperx.widths.at(dim) > U16_MAX) ||
+        (_hyperx.weights.at(dim) > U16_MAX)) {
+      throw std::runtime_error("widths and weights are too large to spill");
+    }
+    values[dim] = static_cast<u16>(_hyperx.widths.at(dim));
+    values[max_dimensions_ + dim] = static_cast<u16>(_hyperx.weights.at(dim));
+  }
+  count_++;
+}
+
+void ResultSpill::merge(const std::function<void(const Hyperx&)>& _visit) {
+  Hyperx hyperx;
+  if (runs_.empty()) {
+    // everything fit in the block
+    order_.resize(count_);
+    for (u64 idx = 0; idx < count_; idx++) {
+      order_[idx] = static_cast<u32>(idx);
+    }
+    std::stable_sort(order_.begin(), order_.end(), [this](u32 _a, u32 _b) {
+      return cost(&block_[_a * record_size_]) <
+             cost(&block_[_b * record_size_]);
+    });
+    for (u64 idx = 0; idx < std::min(count_, max_results_); idx++) {
+      unpack(&block_[order_[idx] * record_size_], &hyperx);
+      _visit(hyperx);
+    }
+    return;
+  }
+
+  if (count_ > 0) {
+    spill();
+  }
+  mergeRuns([this, &hyperx, &_visit](const u8* _record) {
+    unpack(_record, &hyperx);
+    _visit(hyperx);
+  });
+}
+
+u64 ResultSpill::runs() const {
+  return runs_.size();
+}
+
+u64 ResultSpill::spilled() const {
+  return spilled_;
+}
+
+ResultSpill::Reader::Reader(const Run& _run, u64 _record_size)
+    : file_(_run.file), remaining_(_run.count), record_(_record_size) {
+  rewind(file_);
+}
+
+bool ResultSpill::Reader::next() {
+  if (remaining_ == 0) {
+    return false;
+  }
+  if (fread(record_.data(), record_.size(), 1, file_) != 1) {
+    throw std::runtime_error("unable to read a spilled run");
+  }
+  remaining_--;
+  return true;
+}
+
+const u8* ResultSpill::Reader::record() const {
+  return record_.data();
+}
+
+f64 ResultSpill::cost(const u8* _record) const {
+  f64 value;
+  memcpy(&value, _record + kCostOffset, sizeof(f64));
+  return value;
+}
+
+void ResultSpill::unpack(const u8* _record, Hyperx* _hyperx) const {
+  memcpy(&_hyperx->cost, _record + kCostOffset, sizeof(f64));
+  u32 concentration;
+  memcpy(&concentration, _record + kConcentrationOffset, sizeof(u32));
+  _hyperx->concentration = concentration;
+  const u16* values = reinterpret_cast<const u16*>(_record + kWidthsOffset);
+  _hyperx->dimensions = 0;
+  while ((_hyperx->dimensions < max_dimensions_) &&
+         (values[_hyperx->dimensions] != 0)) {
+    _hyperx->dimensions++;
+  }
+  _hyperx->widths.assign(values, values + _hyperx->dimensions);
+  _hyperx->weights.assign(values + max_dimensions_,
+                          values + max_dimensions_ + _hyperx->dimensions);
+}
+
+ResultSpill::Run ResultSpill::create() {
+  // the file is unlinked right away so it disappears when closed
+  std::string name = directory_ + "/hyperxsearch.XXXXXX";
+  s32 fd = mkstemp(&name[0]);
+  if (fd < 0) {
+    throw std::runtime_error("unable to create a spill file in " +
+                             directory_);
+  }
+  unlink(name.c_str());
+  FILE* file = fdopen(fd, "w+b");
+  if (file == nullptr) {
+    close(fd);
+    throw std::runtime_error("unable to open a spill file");
+  }
+  return {file, 0};
+}
+
+void ResultSpill::write(Run* _run, const u8* _record) {
+  if (fwrite(_record, record_size_, 1, _run->file) != 1) {
+    throw std::runtime_error("unable to write a spill file");
+  }
+  _run->count++;
+  spilled_++;
+}
+
+void ResultSpill::spill() {
+  // sort the block, only the best of it can be results
+  order_.resize(count_);
+  for (u64 idx = 0; idx < count_; idx++) {
+    order_[idx] = static_cast<u32>(idx);
+  }
+  u64 keep = std::min(count_, max_results_);
+  auto compare = [this](u32 _a, u32 _b) {
+    f64 lhs = cost(&block_[_a * record_size_]);
+    f64 rhs = cost(&block_[_b * record_size_]);
+    return (lhs < rhs) || ((lhs == rhs) && (_a < _b));
+  };
+  std::partial_sort(order_.begin(), order_.begin() + keep, order_.end(),
+                    compare);
+
+  Run run = create();
+  for (u64 idx = 0; idx < keep; idx++) {
+    write(&run, &block_[order_[idx] * record_size_]);
+  }
+  if (keep == max_results_) {
+    threshold_ = std::min(threshold_, cost(&block_[order_[keep - 1] *
+                                                   record_size_]));
+  }
+  runs_.push_back(run);
+  count_ = 0;
+
+  if (runs_.size() == kFanIn) {
+    compact();
+  }
+}
+
+void ResultSpill::compact() {
+  // merging the runs into one gives the best results so far
+  Run merged = create();
+  f64 last = F64_POS_INF;
+  mergeRuns([this, &merged, &last](const u8* _record) {
+    write(&merged, _record);
+    last = cost(_record);
+  });
+  for (Run& run : runs_) {
+    fclose(run.file);
+  }
+  runs_.clear();
+  if (merged.count == max_results_) {
+    threshold_ = std::min(threshold_, last);
+  }
+  runs_.push_back(merged);
+}
+
+void ResultSpill::mergeRuns(const std::function<void(const u8*)>& _visit) {
+  // ties go to the earlier run, which holds the earlier configurations
+  std::vector<Reader> readers;
+  readers.reserve(runs_.size());
+  for (const Run& run : runs_) {
+    readers.emplace_back(run, record_size_);
+  }
+  typedef std::pair<f64, u64> Head;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  for (u64 idx = 0; idx < readers.size(); idx++) {
+    if (readers[idx].next()) {
+      heads.push({cost(readers[idx].record()), idx});
+    }
+  }
+  for (u64 visited = 0; (visited < max_results_) && !heads.empty();
+       visited++) {
+    u64 idx = heads.top().second;
+    heads.pop();
+    _visit(readers[idx].record());
+    if (readers[idx].next()) {
+      heads.push({cost(readers[idx].record()), idx});
+    }
+  }
+}
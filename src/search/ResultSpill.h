@@ -0,0 +1,117 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_RESULTSPILL_H_
+#define SEARCH_RESULTSPILL_H_
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "prim/prim.h"
+
+struct Hyperx;
+
+// Keeps the best configurations of a search when there are too many to hold
+//  as Hyperx objects. Configurations are packed into fixed size records (cost,
+//  concentration, and 16-bit widths and weights) in a block bounded by a
+//  memory limit. A full block is sorted, truncated to the result count, and
+//  spilled as a run to an unlinked temporary file. Every kFanIn runs are
+//  merged into one, whose last cost becomes the threshold that later
+//  configurations must meet. merge() streams the final results in order.
+class ResultSpill {
+ public:
+  ResultSpill(u64 _max_results, u64 _max_dimensions, u64 _memory_limit,
+              const std::string& _directory);
+  ~ResultSpill();
+
+  // removes all configurations
+  void clear();
+
+  // configurations costlier than this can't be results
+  f64 threshold() const;
+
+  // adds a configuration, only the dimensions, widths, weights, concentration,
+  //  and cost are kept
+  void add(const Hyperx& _hyperx);
+
+  // calls '_visit' with the best configurations in cost order, ties keep the
+  //  order they were added. only the fields kept by add() are set.
+  void merge(const std::function<void(const Hyperx&)>& _visit);
+
+  u64 runs() const;
+  u64 spilled() const;  // records written to runs
+
+ private:
+  static const u64 kFanIn = 16;
+
+  struct Run {
+    FILE* file;
+    u64 count;
+  };
+
+  // reads the records of a run in order
+  class Reader {
+   public:
+    Reader(const Run& _run, u64 _record_size);
+    bool next();
+    const u8* record() const;
+
+   private:
+    FILE* file_;
+    u64 remaining_;
+    std::vector<u8> record_;
+  };
+
+  f64 cost(const u8* _record) const;
+  void unpack(const u8* _record, Hyperx* _hyperx) const;
+  Run create();
+  void write(Run* _run, const u8* _record);
+  void spill();
+  void compact();
+  // merges the runs, passing up to the result count of records to '_visit'
+  void mergeRuns(const std::function<void(const u8*)>& _visit);
+
+  const u64 max_results_;
+  const u64 max_dimensions_;
+  const u64 record_size_;
+  const std::string directory_;
+  u64 capacity_;  // records in the block
+
+  std::vector<u8> block_;
+  std::vector<u32> order_;
+  u64 count_;
+  std::vector<Run> runs_;
+  f64 threshold_;
+  u64 spilled_;
+};
+
+#endif  // SEARCH_RESULTSPILL_H_
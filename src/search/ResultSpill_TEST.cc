@@ -0,0 +1,171 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/ResultSpill.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/RouterChannelCount.h"
+
+namespace {
+
+// adds random configurations with many tied costs and checks that merge()
+//  yields the best in cost order with ties in the order they were added
+void checkSpill(u64 _max_results, u64 _memory_limit, u64 _count) {
+  ResultSpill spill(_max_results, 3, _memory_limit, testing::TempDir());
+  std::mt19937_64 prng(_max_results + _memory_limit + _count);
+  std::vector<Hyperx> added;
+  for (u64 idx = 0; idx < _count; idx++) {
+    Hyperx hyperx;
+    hyperx.dimensions = 1 + (prng() % 3);
+    for (u64 dim = 0; dim < hyperx.dimensions; dim++) {
+      hyperx.widths.push_back(2 + (prng() % 60000));
+      hyperx.weights.push_back(1 + (prng() % 60000));
+    }
+    hyperx.concentration = idx;
+    hyperx.cost = (prng() % 2000) * 0.25;
+    spill.add(hyperx);
+    added.push_back(hyperx);
+  }
+
+  std::stable_sort(added.begin(), added.end(),
+                   [](const Hyperx& _a, const Hyperx& _b) {
+                     return _a.cost < _b.cost;
+                   });
+  added.resize(std::min<u64>(added.size(), _max_results));
+  if (added.size() == _max_results) {
+    EXPECT_GE(spill.threshold(), added.back().cost);
+  }
+
+  u64 visited = 0;
+  spill.merge([&](const Hyperx& _hyperx) {
+    ASSERT_LT(visited, added.size());
+    const Hyperx& expected = added.at(visited);
+    EXPECT_EQ(_hyperx.cost, expected.cost);
+    EXPECT_EQ(_hyperx.concentration, expected.concentration);
+    EXPECT_EQ(_hyperx.dimensions, expected.dimensions);
+    EXPECT_EQ(_hyperx.widths, expected.widths);
+    EXPECT_EQ(_hyperx.weights, expected.weights);
+    visited++;
+  });
+  EXPECT_EQ(visited, added.size());
+}
+
+}  // namespace
+
+TEST(ResultSpill, inMemory) {
+  checkSpill(100, 1 << 20, 1000);
+  checkSpill(5000, 1 << 20, 1000);
+}
+
+TEST(ResultSpill, runs) {
+  // a few runs without compaction
+  checkSpill(1000, 1 << 12, 1000);
+  checkSpill(10, 1 << 12, 1000);
+}
+
+TEST(ResultSpill, compaction) {
+  // many more runs than are merged at once
+  checkSpill(1, 1 << 12, 100000);
+  checkSpill(7, 1 << 12, 100000);
+  checkSpill(5000, 1 << 12, 100000);
+  checkSpill(100000, 1 << 14, 100000);
+}
+
+TEST(ResultSpill, clear) {
+  ResultSpill spill(10, 2, 1 << 10, testing::TempDir());
+  Hyperx hyperx;
+  hyperx.dimensions = 2;
+  hyperx.widths = {4, 5};
+  hyperx.weights = {2, 1};
+  for (u64 idx = 0; idx < 1000; idx++) {
+    hyperx.concentration = idx;
+    hyperx.cost = static_cast<f64>(idx % 100);
+    spill.add(hyperx);
+  }
+  EXPECT_GT(spill.runs(), 0u);
+  EXPECT_LT(spill.threshold(), F64_POS_INF);
+
+  spill.clear();
+  EXPECT_EQ(spill.runs(), 0u);
+  EXPECT_EQ(spill.threshold(), F64_POS_INF);
+  u64 visited = 0;
+  spill.merge([&](const Hyperx&) { visited++; });
+  EXPECT_EQ(visited, 0u);
+}
+
+TEST(ResultSpill, engine) {
+  // a search keeps the same results in memory and spilled
+  RouterChannelCount calc;
+  for (u64 max_results : {1u, 50u, 3000u}) {
+    Engine memory(1, 4, 2, 24, 1, 24, 200, 500, 0.3, 2.0, 24, 24, false,
+                  false, max_results, &calc);
+    memory.run();
+
+    Engine spilled(1, 4, 2, 24, 1, 24, 200, 500, 0.3, 2.0, 24, 24, false,
+                   false, max_results, &calc);
+    ResultSpill spill(max_results, 4, 1 << 12, testing::TempDir());
+    spilled.setResultSpill(&spill);
+    spilled.run();
+    EXPECT_TRUE(spilled.results().empty());
+
+    // ties at the last cost may keep different configurations
+    typedef std::tuple<f64, std::vector<u64>, std::vector<u64>, u64> Key;
+    std::vector<Key> expected;
+    f64 last = memory.results().back().cost;
+    for (const Hyperx& res : memory.results()) {
+      if (res.cost < last) {
+        expected.emplace_back(res.cost, res.widths, res.weights,
+                              res.concentration);
+      }
+    }
+    std::vector<Key> actual;
+    u64 count = 0;
+    spill.merge([&](const Hyperx& _hyperx) {
+      EXPECT_EQ(_hyperx.cost, memory.results().at(count).cost);
+      if (_hyperx.cost < last) {
+        actual.emplace_back(_hyperx.cost, _hyperx.widths, _hyperx.weights,
+                            _hyperx.concentration);
+      }
+      count++;
+    });
+    EXPECT_EQ(count, memory.results().size());
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(actual, expected);
+  }
+}
@@ -37,3 +37,7 @@ RouterChannelCount::~RouterChannelCount() {}
 f64 RouterChannelCount::cost(const Hyperx& _hyperx) const {
   return _hyperx.routers + _hyperx.channels * 0.000000001;
 }
+
+f64 RouterChannelCount::networkCost(const Network& _network) const {
+  return _network.routers + _network.channels * 0.000000001;
+}
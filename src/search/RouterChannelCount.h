@@ -40,6 +40,12 @@ class RouterChannelCount : public Calculator {
   RouterChannelCount();
   ~RouterChannelCount();
   f64 cost(const Hyperx& _hyperx) const override;
+  f64 networkCost(const Network& _network) const override;
+};
+
+template <>
+struct CostTraits<RouterChannelCount> {
+  static constexpr bool kReadsBisections = false;
 };
 
 #endif  // SEARCH_ROUTERCHANNELCOUNT_H_
@@ -0,0 +1,188 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/RouterSkus.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+RouterSkus::RouterSkus(const std::string& _filename, Calculator* _base,
+                       f64 _min_bandwidth, f64 _max_bandwidth)
+    : base_(_base), min_bandwidth_(_min_bandwidth),
+      max_bandwidth_(_max_bandwidth) {
+  std::ifstream file(_filename);
+  if (!file) {
+    throw std::runtime_error("unable to open SKU file " + _filename);
+  }
+  std::string line;
+  for (u64 number = 1; std::getline(file, line); number++) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream tokens(line);
+    Sku sku;
+    if (!(tokens >> sku.name)) {
+      continue;
+    }
+    sku.speed = 1.0;
+    bool ok = static_cast<bool>(tokens >> sku.radix >> sku.price);
+    if (ok && !(tokens >> sku.speed)) {
+      sku.speed = 1.0;
+      ok = tokens.eof();
+    }
+    std::string extra;
+    if (!ok || (tokens >> extra) || (sku.radix < 2) || !(sku.speed > 0.0)) {
+      throw std::runtime_error(_filename + ":" + std::to_string(number) +
+                               ": invalid SKU");
+    }
+    skus_.push_back(sku);
+  }
+  if (skus_.empty()) {
+    throw std::runtime_error("the SKU file has no SKUs");
+  }
+
+  // the first fitting SKU is the cheapest
+  std::stable_sort(skus_.begin(), skus_.end(),
+                   [](const Sku& _a, const Sku& _b) {
+                     return _a.price < _b.price;
+                   });
+
+  fields_ = base_->extFields();
+  fields_.push_back("SKU");
+}
+
+RouterSkus::~RouterSkus() {
+  delete base_;
+}
+
+u64 RouterSkus::maxRadix() const {
+  u64 radix = 0;
+  for (const Sku& sku : skus_) {
+    radix = std::max(radix, sku.radix);
+  }
+  return radix;
+}
+
+void RouterSkus::engineBandwidth(f64* _min_bandwidth,
+                                 f64* _max_bandwidth) const {
+  f64 slowest = F64_POS_INF;
+  f64 fastest = 0.0;
+  for (const Sku& sku : skus_) {
+    slowest = std::min(slowest, sku.speed);
+    fastest = std::max(fastest, sku.speed);
+  }
+  *_min_bandwidth = min_bandwidth_ / fastest;
+  *_max_bandwidth = max_bandwidth_ / slowest;
+}
+
+f64 RouterSkus::cost(const Hyperx& _hyperx) const {
+  u64 fit = sku(_hyperx);
+  if (fit == U64_MAX) {
+    return F64_POS_INF;
+  }
+  return base_->cost(_hyperx) + _hyperx.routers * skus_[fit].price;
+}
+
+f64 RouterSkus::networkCost(const Network& _network) const {
+  u64 fit = sku(_network);
+  if (fit == U64_MAX) {
+    return F64_POS_INF;
+  }
+  return base_->networkCost(_network) + _network.routers * skus_[fit].price;
+}
+
+f64 RouterSkus::lowerBound(const Hyperx& _hyperx,
+                           const std::vector<u64>& _max_weights) const {
+  // no weights make the router radix smaller than unit weights do, so the
+  //  cheapest SKU covering that radix is the cheapest that can fit
+  u64 radix = _hyperx.concentration;
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    radix += _hyperx.widths.at(dim) - 1;
+  }
+  for (const Sku& candidate : skus_) {
+    if (candidate.radix >= radix) {
+      return base_->lowerBound(_hyperx, _max_weights) +
+             _hyperx.routers * candidate.price;
+    }
+  }
+  return F64_POS_INF;
+}
+
+u64 RouterSkus::classes() const {
+  return skus_.size();
+}
+
+u64 RouterSkus::classify(const Hyperx& _hyperx) const {
+  return sku(_hyperx);
+}
+
+const std::vector<std::string>& RouterSkus::extFields() const {
+  return fields_;
+}
+
+std::unordered_map<std::string, std::string> RouterSkus::extValues(
+    const Hyperx& _hyperx) const {
+  std::unordered_map<std::string, std::string> values =
+      base_->extValues(_hyperx);
+  u64 fit = sku(_hyperx);
+  values["SKU"] = (fit == U64_MAX) ? "none" : skus_.at(fit).name;
+  return values;
+}
+
+std::unordered_map<std::string, std::string> RouterSkus::networkExtValues(
+    const Network& _network) const {
+  std::unordered_map<std::string, std::string> values =
+      base_->networkExtValues(_network);
+  u64 fit = sku(_network);
+  values["SKU"] = (fit == U64_MAX) ? "none" : skus_.at(fit).name;
+  return values;
+}
+
+void RouterSkus::analyze(const std::deque<Hyperx>& _results) {
+  base_->analyze(_results);
+}
+
+u64 RouterSkus::sku(const Network& _network) const {
+  f64 smallest = F64_POS_INF;
+  f64 largest = F64_NEG_INF;
+  for (f64 bisection : _network.bisections) {
+    smallest = std::min(smallest, bisection);
+    largest = std::max(largest, bisection);
+  }
+  for (u64 idx = 0; idx < skus_.size(); idx++) {
+    const Sku& candidate = skus_[idx];
+    if ((candidate.radix >= _network.router_radix) &&
+        (smallest * candidate.speed >= min_bandwidth_) &&
+        (largest * candidate.speed <= max_bandwidth_)) {
+      return idx;
+    }
+  }
+  return U64_MAX;
+}
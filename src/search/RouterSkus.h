@@ -0,0 +1,96 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_ROUTERSKUS_H_
+#define SEARCH_ROUTERSKUS_H_
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Calculator.h"
+#include "search/Engine.h"
+
+// Prices each configuration with the cheapest router SKU (model) that fits
+//  it, on top of the cost of another calculator, so one search at the largest
+//  SKU radix covers every SKU. Each SKU is a class, the engine keeps the best
+//  configuration using each SKU besides the overall results.
+//
+// The SKU file has one SKU per line, '#' starts a comment:
+//  <name> <radix> <price> [speed]
+// 'speed' (1) scales the port bandwidth, a SKU only fits when its scaled
+//  bisections are within the bandwidth limits and its radix covers the router
+//  radix. The engine's limits must be widened by the speeds for faster SKUs to
+//  reach the calculator, see engineBandwidth().
+class RouterSkus : public Calculator {
+ public:
+  // takes ownership of '_base'
+  RouterSkus(const std::string& _filename, Calculator* _base,
+             f64 _min_bandwidth, f64 _max_bandwidth);
+  ~RouterSkus();
+
+  u64 maxRadix() const;
+  // the bandwidth limits of the engine admitting every SKU
+  void engineBandwidth(f64* _min_bandwidth, f64* _max_bandwidth) const;
+
+  f64 cost(const Hyperx& _hyperx) const override;
+  f64 networkCost(const Network& _network) const override;
+  f64 lowerBound(const Hyperx& _hyperx,
+                 const std::vector<u64>& _max_weights) const override;
+  u64 classes() const override;
+  u64 classify(const Hyperx& _hyperx) const override;
+  const std::vector<std::string>& extFields() const override;
+  std::unordered_map<std::string, std::string> extValues(
+      const Hyperx& _hyperx) const override;
+  std::unordered_map<std::string, std::string> networkExtValues(
+      const Network& _network) const override;
+  void analyze(const std::deque<Hyperx>& _results) override;
+
+ private:
+  struct Sku {
+    std::string name;
+    u64 radix;
+    f64 price;
+    f64 speed;
+  };
+
+  Calculator* base_;
+  f64 min_bandwidth_;
+  f64 max_bandwidth_;
+  std::vector<Sku> skus_;  // by price
+  std::vector<std::string> fields_;
+
+  // the cheapest fitting SKU, U64_MAX if none fits
+  u64 sku(const Network& _network) const;
+};
+
+#endif  // SEARCH_ROUTERSKUS_H_
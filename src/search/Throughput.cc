@@ -0,0 +1,160 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Throughput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+Throughput::Throughput(
+    const std::unordered_map<std::string, std::string>& _settings)
+    : objective_(Pattern::kNone),
+      fields_({"Uniform", "Permutation", "Adversarial", "Valiant"}) {
+  for (const auto& setting : _settings) {
+    if (setting.first == "objective") {
+      if (setting.second == "uniform") {
+        objective_ = Pattern::kUniform;
+      } else if (setting.second == "permutation") {
+        objective_ = Pattern::kPermutation;
+      } else if (setting.second == "adversarial") {
+        objective_ = Pattern::kAdversarial;
+      } else if (setting.second == "valiant") {
+        objective_ = Pattern::kValiant;
+      } else {
+        throw std::runtime_error("unknown throughput objective: " +
+                                 setting.second);
+      }
+    } else {
+      throw std::runtime_error("unknown throughput setting: " +
+                               setting.first);
+    }
+  }
+}
+
+Throughput::~Throughput() {}
+
+f64 Throughput::cost(const Hyperx& _hyperx) const {
+  f64 base = RouterChannelCount::cost(_hyperx);
+  if (objective_ == Pattern::kNone) {
+    return base;
+  }
+  return base / throughput(_hyperx, objective_);
+}
+
+f64 Throughput::networkCost(const Network& _network) const {
+  if (objective_ != Pattern::kNone) {
+    throw std::runtime_error("the throughput objective only supports HyperX");
+  }
+  return RouterChannelCount::networkCost(_network);
+}
+
+const std::vector<std::string>& Throughput::extFields() const {
+  return fields_;
+}
+
+std::unordered_map<std::string, std::string> Throughput::extValues(
+    const Hyperx& _hyperx) const {
+  std::vector<f64> values = throughputs(_hyperx);
+  std::unordered_map<std::string, std::string> ext;
+  char buf[32];
+  for (u64 idx = 0; idx < fields_.size(); idx++) {
+    snprintf(buf, sizeof(buf), "%.3f", values.at(idx));
+    ext[fields_.at(idx)] = buf;
+  }
+  return ext;
+}
+
+f64 Throughput::throughput(const Hyperx& _hyperx, Pattern _pattern) {
+  // same as throughputs() without the patterns that aren't needed
+  f64 terminals = static_cast<f64>(_hyperx.concentration);
+  f64 limit = 1.0;
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    f64 width = static_cast<f64>(_hyperx.widths.at(dim));
+    f64 weight = static_cast<f64>(_hyperx.weights.at(dim));
+    switch (_pattern) {
+      case Pattern::kUniform:
+      case Pattern::kValiant:
+        limit = std::min(limit, width * weight / terminals);
+        break;
+      case Pattern::kPermutation: {
+        f64 pairs = static_cast<f64>(_hyperx.routers) * (width - 1);
+        limit = std::min(
+            limit, weight / expectedMaximum(terminals / width, pairs));
+        break;
+      }
+      case Pattern::kAdversarial:
+        limit = std::min(limit, weight / terminals);
+        break;
+      case Pattern::kNone:
+        break;
+    }
+  }
+  return (_pattern == Pattern::kValiant) ? (limit / 2.0) : limit;
+}
+
+std::vector<f64> Throughput::throughputs(const Hyperx& _hyperx) {
+  // the throughput of every pattern is limited by its worst dimension
+  f64 terminals = static_cast<f64>(_hyperx.concentration);
+  f64 uniform = 1.0;
+  f64 permutation = 1.0;
+  f64 adversarial = 1.0;
+  for (u64 dim = 0; dim < _hyperx.dimensions; dim++) {
+    f64 width = static_cast<f64>(_hyperx.widths.at(dim));
+    f64 weight = static_cast<f64>(_hyperx.weights.at(dim));
+    f64 pairs = static_cast<f64>(_hyperx.routers) * (width - 1);
+    uniform = std::min(uniform, width * weight / terminals);
+    permutation = std::min(
+        permutation, weight / expectedMaximum(terminals / width, pairs));
+    adversarial = std::min(adversarial, weight / terminals);
+  }
+  return {uniform, permutation, adversarial, uniform / 2.0};
+}
+
+f64 Throughput::expectedMaximum(f64 _mean, f64 _count) {
+  // E[max] is the sum over m >= 0 of P(max > m) = 1 - (1 - tail(m))^count,
+  //  where tail(m) = P(X > m) of a single Poisson pair, stopping once the
+  //  remaining terms are negligible. The most loaded pair carries at least
+  //  one flow.
+  f64 expected = 0.0;
+  f64 pmf = std::exp(-_mean);
+  f64 tail = 1.0 - pmf;
+  for (u64 m = 0; (m <= _mean) || (tail > 0.0); m++) {
+    f64 exceeds = -std::expm1(_count * std::log1p(-tail));
+    if ((m > _mean) && (exceeds < 1e-9)) {
+      break;
+    }
+    expected += exceeds;
+    pmf *= _mean / (m + 1);
+    tail = std::max(0.0, tail - pmf);
+  }
+  return std::max(1.0, expected);
+}
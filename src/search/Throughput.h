@@ -0,0 +1,94 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_THROUGHPUT_H_
+#define SEARCH_THROUGHPUT_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/RouterChannelCount.h"
+
+// Costs like RouterChannelCount and estimates the saturation throughput, as a
+//  fraction of the terminal bandwidth, from the channel loads of each
+//  dimension under dimension order minimal routing:
+//  Uniform      uniform random traffic loads every channel of a dimension
+//               evenly, giving min(1, W*K/T)
+//  Permutation  each router pair of a dimension carries a Poisson number of
+//               flows (mean T/W), the throughput is K over the expected most
+//               loaded pair
+//  Adversarial  all terminals of a router send to one router aligned in a
+//               dimension, giving min(1, K/T)
+//  Valiant      any pattern routed through a random intermediate router
+//               loads channels as twice uniform random traffic
+//
+// The 'objective' setting (uniform, permutation, adversarial, or valiant)
+//  divides the cost by that throughput so it drives the search. Only the
+//  objective's pattern is computed per cost, the other families of a
+//  multi-family search can't be costed with an objective.
+class Throughput : public RouterChannelCount {
+ public:
+  explicit Throughput(
+      const std::unordered_map<std::string, std::string>& _settings);
+  ~Throughput();
+
+  f64 cost(const Hyperx& _hyperx) const override;
+  f64 networkCost(const Network& _network) const override;
+  const std::vector<std::string>& extFields() const override;
+  std::unordered_map<std::string, std::string> extValues(
+      const Hyperx& _hyperx) const override;
+
+ private:
+  enum class Pattern : u8 {
+    kUniform = 0,
+    kPermutation = 1,
+    kAdversarial = 2,
+    kValiant = 3,
+    kNone = 4
+  };
+
+  // the throughput of one pattern, and of all indexed by Pattern
+  static f64 throughput(const Hyperx& _hyperx, Pattern _pattern);
+  static std::vector<f64> throughputs(const Hyperx& _hyperx);
+  static f64 expectedMaximum(f64 _mean, f64 _count);
+
+  Pattern objective_;
+  std::vector<std::string> fields_;
+};
+
+template <>
+struct CostTraits<Throughput> {
+  static constexpr bool kReadsBisections = false;
+};
+
+#endif  // SEARCH_THROUGHPUT_H_
@@ -0,0 +1,171 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Torus.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "strop/strop.h"
+
+TorusEngine::TorusEngine(const Engine* _limits) : FamilyEngine<Torus>(_limits) {}
+
+TorusEngine::~TorusEngine() {}
+
+std::string TorusEngine::family() const {
+  return "torus";
+}
+
+void TorusEngine::run() {
+  results_.clear();
+  torus_ = Torus();
+
+  /*
+   * loop over the number of dimensions
+   */
+  for (torus_.dimensions = limits_->minDimensions();
+       torus_.dimensions <= limits_->maxDimensions(); torus_.dimensions++) {
+    // every dimension is a ring using two ports per unit of weight
+    if (std::max<u64>(1, limits_->minConcentration()) +
+            2 * torus_.dimensions >
+        limits_->maxRadix()) {
+      break;
+    }
+    torus_.widths.assign(torus_.dimensions, 2);
+    torus_.weights.assign(torus_.dimensions, 1);
+    torus_.bisections.assign(torus_.dimensions, 0.0);
+    widths(0, 1, 0);
+  }
+}
+
+std::string TorusEngine::parameters(u64 _index) const {
+  const Torus& torus = results_.at(_index);
+  return "S=" + strop::vecString<u64>(torus.widths) +
+         " K=" + strop::vecString<u64>(torus.weights) +
+         " T=" + std::to_string(torus.concentration);
+}
+
+u64 TorusEngine::firstWeight(u64 _width, u64 _concentration) const {
+  // at or below the smallest weight, the limit checks reject the ones below it
+  return std::max<u64>(
+      1, static_cast<u64>(std::floor(limits_->minBandwidth() * _width *
+                                     _concentration / 4.0)));
+}
+
+void TorusEngine::widths(u64 _dim, u64 _routers, u64 _weights) {
+  // widths are generated in non-decreasing order. every remaining dimension
+  //  is at least as wide as this one, which bounds the number of routers and
+  //  the weights needed to meet the minimum bandwidth.
+  u64 remaining = torus_.dimensions - _dim;
+  u64 min_concentration = std::max<u64>(1, limits_->minConcentration());
+  u64 first = (_dim == 0) ? 2 : torus_.widths.at(_dim - 1);
+  for (u64 width = first; width <= limits_->maxWidth(); width++) {
+    u64 routers = _routers;
+    bool too_many_routers = false;
+    for (u64 rem = 0; rem < remaining && !too_many_routers; rem++) {
+      too_many_routers = __builtin_mul_overflow(routers, width, &routers) ||
+                         (routers > limits_->maxTerminals());
+    }
+    u64 first_weights =
+        _weights + remaining * firstWeight(width, min_concentration);
+    if (too_many_routers ||
+        (min_concentration + 2 * first_weights > limits_->maxRadix())) {
+      // wider configurations are only larger
+      break;
+    }
+
+    torus_.widths.at(_dim) = width;
+    if (remaining == 1) {
+      torus_.routers = routers;
+      concentrations();
+    } else {
+      widths(_dim + 1, _routers * width,
+             _weights + firstWeight(width, min_concentration));
+    }
+  }
+}
+
+void TorusEngine::concentrations() {
+  // try possible values for terminals per router, starting at the first one
+  //  that reaches the minimum number of terminals
+  u64 first = std::max<u64>(
+      std::max<u64>(1, limits_->minConcentration()),
+      (limits_->minTerminals() + torus_.routers - 1) / torus_.routers);
+  for (torus_.concentration = first;
+       torus_.concentration <= limits_->maxConcentration();
+       torus_.concentration++) {
+    torus_.terminals = torus_.routers * torus_.concentration;
+    if (torus_.terminals > limits_->maxTerminals()) {
+      break;
+    }
+    u64 first_weights = 0;
+    for (u64 width : torus_.widths) {
+      first_weights += firstWeight(width, torus_.concentration);
+    }
+    if (torus_.concentration + 2 * first_weights > limits_->maxRadix()) {
+      break;
+    }
+    weights(0, torus_.concentration, first_weights);
+  }
+}
+
+void TorusEngine::weights(u64 _dim, u64 _radix, u64 _weights) {
+  // _weights is the sum of the first weights of the remaining dimensions
+  u64 first = firstWeight(torus_.widths.at(_dim), torus_.concentration);
+  u64 rest = _weights - first;
+  if ((_dim > 0) && (torus_.widths.at(_dim) == torus_.widths.at(_dim - 1))) {
+    // equal widths are interchangeable, keep their weights non-decreasing
+    first = std::max(first, torus_.weights.at(_dim - 1));
+  }
+  for (u64 weight = first; weight <= limits_->maxWeight(); weight++) {
+    u64 radix = _radix + 2 * weight;
+    torus_.bisections.at(_dim) =
+        (4.0 * weight) / (torus_.widths.at(_dim) * torus_.concentration);
+    if ((radix + 2 * rest > limits_->maxRadix()) ||
+        (torus_.bisections.at(_dim) > limits_->maxBandwidth())) {
+      break;
+    }
+    torus_.weights.at(_dim) = weight;
+    if (_dim + 1 < torus_.dimensions) {
+      weights(_dim + 1, radix, rest);
+    } else {
+      torus_.router_radix = radix;
+      if (withinLimits(torus_)) {
+        // each ring has as many channels as routers
+        u64 total_weight = 0;
+        for (u64 w : torus_.weights) {
+          total_weight += w;
+        }
+        torus_.channels = torus_.terminals + torus_.routers * total_weight;
+        consider(&torus_);
+      }
+    }
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_TORUS_H_
+#define SEARCH_TORUS_H_
+
+#include <string>
+#include <vector>
+
+#include "prim/prim.h"
+#include "search/Engine.h"
+#include "search/FamilyEngine.h"
+#include "search/Network.h"
+
+struct Torus : public Network {
+  u64 dimensions;            // L
+  std::vector<u64> widths;   // S
+  u64 concentration;         // T
+  std::vector<u64> weights;  // K
+};
+
+class TorusEngine : public FamilyEngine<Torus> {
+ public:
+  explicit TorusEngine(const Engine* _limits);
+  ~TorusEngine();
+
+  std::string family() const override;
+  void run() override;
+  std::string parameters(u64 _index) const override;
+
+ private:
+  // the smallest weight of a dimension that might meet the minimum bandwidth
+  u64 firstWeight(u64 _width, u64 _concentration) const;
+
+  void widths(u64 _dim, u64 _routers, u64 _weights);
+  void concentrations();
+  void weights(u64 _dim, u64 _radix, u64 _weights);
+
+  Torus torus_;
+};
+
+#endif  // SEARCH_TORUS_H_
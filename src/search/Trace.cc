@@ -0,0 +1,167 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "search/Trace.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "search/Engine.h"
+
+static const char kMagic[8] = {'H', 'X', 'T', 'R', 'A', 'C', 'E', '1'};
+static const u32 kVersion = 1;
+
+// each tracer gets a unique id so a thread's cached buffer is never reused by
+//  a later tracer at the same address
+static std::atomic<u64> next_id(1);
+
+namespace {
+struct Cache {
+  u64 id;
+  void* buffer;
+};
+}  // namespace
+
+static thread_local Cache cache = {0, nullptr};
+
+static u16 saturate(u64 _value) {
+  return (_value > U16_MAX) ? U16_MAX : static_cast<u16>(_value);
+}
+
+Tracer::Tracer(const std::string& _filename, u8 _level, u64 _sample)
+    : level_(_level), sample_(_sample), id_(next_id++), events_(0),
+      failed_(false) {
+  if (sample_ == 0) {
+    throw std::runtime_error("trace sample rate must be positive");
+  }
+  file_ = fopen(_filename.c_str(), "wb");
+  if (file_ == nullptr) {
+    throw std::runtime_error("unable to open trace file: " + _filename);
+  }
+  u32 size = sizeof(TraceEvent);
+  if ((fwrite(kMagic, sizeof(kMagic), 1, file_) != 1) ||
+      (fwrite(&kVersion, sizeof(kVersion), 1, file_) != 1) ||
+      (fwrite(&size, sizeof(size), 1, file_) != 1)) {
+    fclose(file_);
+    throw std::runtime_error("unable to write trace file: " + _filename);
+  }
+}
+
+Tracer::~Tracer() {
+  try {
+    flush();
+  } catch (std::runtime_error& e) {
+    fprintf(stderr, "%s\n", e.what());
+  }
+  fclose(file_);
+}
+
+void Tracer::record(u8 _level, TraceStage _stage, TraceReason _reason,
+                    const Hyperx& _hyperx) {
+  Buffer* buffer = this->buffer();
+  if (sample_ > 1) {
+    buffer->skipped++;
+    if (buffer->skipped < sample_) {
+      return;
+    }
+    buffer->skipped = 0;
+  }
+
+  TraceEvent& event = buffer->events[buffer->count];
+  event.stage = static_cast<u8>(_stage);
+  event.reason = static_cast<u8>(_reason);
+  event.level = _level;
+  event.dimensions = static_cast<u8>(_hyperx.dimensions);
+  event.concentration = static_cast<u32>(
+      (_hyperx.concentration > U32_MAX) ? U32_MAX : _hyperx.concentration);
+  u64 widths = std::min(_hyperx.widths.size(), kTraceEventDimensions);
+  u64 weights = std::min(_hyperx.weights.size(), kTraceEventDimensions);
+  for (u64 dim = 0; dim < kTraceEventDimensions; dim++) {
+    event.widths[dim] = (dim < widths) ? saturate(_hyperx.widths[dim]) : 0;
+    event.weights[dim] = (dim < weights) ? saturate(_hyperx.weights[dim]) : 0;
+  }
+
+  buffer->count++;
+  if (buffer->count == kBufferEvents) {
+    std::lock_guard<std::mutex> guard(lock_);
+    write(buffer);
+  }
+}
+
+void Tracer::flush() {
+  // only call this while no thread is recording
+  std::lock_guard<std::mutex> guard(lock_);
+  for (std::unique_ptr<Buffer>& buffer : buffers_) {
+    write(buffer.get());
+  }
+  if ((fflush(file_) != 0) || failed_.load()) {
+    failed_ = true;
+    throw std::runtime_error("unable to write trace file");
+  }
+}
+
+u64 Tracer::events() const {
+  return events_.load();
+}
+
+bool Tracer::failed() const {
+  return failed_.load();
+}
+
+Tracer::Buffer* Tracer::buffer() {
+  if (cache.id != id_) {
+    std::lock_guard<std::mutex> guard(lock_);
+    buffers_.emplace_back(new Buffer());
+    Buffer* buffer = buffers_.back().get();
+    buffer->thread = static_cast<u32>(buffers_.size() - 1);
+    buffer->count = 0;
+    buffer->skipped = 0;
+    cache.id = id_;
+    cache.buffer = buffer;
+  }
+  return static_cast<Buffer*>(cache.buffer);
+}
+
+void Tracer::write(Buffer* _buffer) {
+  // a partial block would corrupt the file, so drop everything after a failure
+  if ((_buffer->count == 0) || failed_.load()) {
+    _buffer->count = 0;
+    return;
+  }
+  u32 count = static_cast<u32>(_buffer->count);
+  _buffer->count = 0;
+  if ((fwrite(&_buffer->thread, sizeof(_buffer->thread), 1, file_) != 1) ||
+      (fwrite(&count, sizeof(count), 1, file_) != 1) ||
+      (fwrite(_buffer->events, sizeof(TraceEvent), count, file_) != count)) {
+    failed_ = true;
+    return;
+  }
+  events_ += count;
+}
@@ -0,0 +1,139 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * - Neither the name of prim nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior
+ * written permission.
+ *
+ * See the NOTICE file distributed with this work for additional information
+ * regarding copyright ownership.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SEARCH_TRACE_H_
+#define SEARCH_TRACE_H_
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "prim/prim.h"
+
+struct Hyperx;
+
+// the search stage that emitted an event
+enum class TraceStage : u8 {
+  kStage1 = 1,    // width configuration (S)
+  kStage2 = 2,    // concentration (T)
+  kStage3 = 3,    // weight configuration (K)
+  kStage4 = 4,    // feasible configuration
+  kStage5 = 5,    // costed configuration
+  kEvaluate = 6,  // Engine::evaluate()
+};
+
+// why the event was emitted
+enum class TraceReason : u8 {
+  kEnter = 0,          // the stage was entered
+  kAccept = 1,         // the configuration passed all checks
+  kConcentration = 2,  // no concentration fits within the limits
+  kTerminalsLow = 3,   // too few terminals
+  kTerminalsHigh = 4,  // too many terminals
+  kRadixLow = 5,       // router radix below the minimum
+  kRadixHigh = 6,      // router radix above the maximum
+  kBandwidthLow = 7,   // a bisection below the minimum bandwidth
+  kBandwidthHigh = 8,  // a bisection above the maximum bandwidth
+  kInfeasible = 9,     // evaluate() found a limit violation
+  kPruned = 10,        // the cost lower bound exceeds all results
+  kUnclassified = 11,  // the cost function has no class for it
+};
+
+// widths and weights beyond this many dimensions are not recorded
+static const u64 kTraceEventDimensions = 14;
+
+// a fixed size trace record. values that don't fit in a field are saturated.
+struct TraceEvent {
+  u8 stage;
+  u8 reason;
+  u8 level;
+  u8 dimensions;
+  u32 concentration;
+  u16 widths[kTraceEventDimensions];
+  u16 weights[kTraceEventDimensions];
+};
+static_assert(sizeof(TraceEvent) == 64, "trace events must be 64 bytes");
+
+// Records search events into per-thread buffers that are written to a binary
+//  file as each fills. Recording is lock-free, only flushing a full buffer
+//  takes the file lock. The file starts with a header (magic, version, event
+//  size) followed by blocks of (thread, count) and that many events. See
+//  scripts/trace_decode.py.
+class Tracer {
+ public:
+  Tracer(const std::string& _filename, u8 _level, u64 _sample);
+  ~Tracer();
+
+  // checks whether events of this level are recorded
+  inline bool enabled(u8 _level) const {
+    return _level <= level_;
+  }
+
+  // records an event, sampling 1 of every 'sample' events per thread. this
+  //  never throws, a failed write is reported by failed() and flush().
+  void record(u8 _level, TraceStage _stage, TraceReason _reason,
+              const Hyperx& _hyperx);
+
+  // writes all buffered events to the file, throws if any write failed
+  void flush();
+
+  // the number of events written to the file
+  u64 events() const;
+
+  // checks whether a write failed, later events are dropped
+  bool failed() const;
+
+ private:
+  static const u64 kBufferEvents = 4096;
+
+  struct Buffer {
+    u32 thread;
+    u64 count;
+    u64 skipped;
+    TraceEvent events[kBufferEvents];
+  };
+
+  Buffer* buffer();
+  void write(Buffer* _buffer);
+
+  const u8 level_;
+  const u64 sample_;
+  const u64 id_;
+
+  FILE* file_;
+  std::mutex lock_;
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+  std::atomic<u64> events_;
+  std::atomic<bool> failed_;
+};
+
+#endif  // SEARCH_TRACE_H_